@@ -0,0 +1,49 @@
+#
+# Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+#
+# This program is free software: You may redistribute and/or modify under the
+# terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at Client's option) any
+# later version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+#
+#
+# Temporary instance for the benchmark and stress scripts. To be sourced.
+#
+# Environment variables:
+#     PG_CONFIG              pg_config of the installation to use
+#     BENCH_PORT             port of the temporary instance (default 54329)
+#
+
+PG_CONFIG=${PG_CONFIG:-pg_config}
+BINDIR=$("$PG_CONFIG" --bindir)
+PORT=${BENCH_PORT:-54329}
+WORKDIR=$(mktemp -d -t session_variable_bench.XXXXXX)
+
+export PGHOST=$WORKDIR
+export PGPORT=$PORT
+export PGUSER=postgres
+export PGDATABASE=postgres
+
+stop_instance() {
+    "$BINDIR/pg_ctl" -D "$WORKDIR/data" -m immediate stop >/dev/null 2>&1 || true
+    rm -rf "$WORKDIR"
+}
+trap stop_instance EXIT
+
+start_instance() {
+    "$BINDIR/initdb" -D "$WORKDIR/data" -A trust -U postgres >/dev/null
+    "$BINDIR/pg_ctl" -D "$WORKDIR/data" -l "$WORKDIR/postmaster.log" -w \
+        -o "-p $PORT -k $WORKDIR -c listen_addresses='' -c fsync=off" start >/dev/null
+    sql -c "create extension session_variable_bench cascade" >/dev/null
+}
+
+sql() {
+    "$BINDIR/psql" -X -q -v ON_ERROR_STOP=1 -At "$@"
+}
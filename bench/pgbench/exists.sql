@@ -0,0 +1,3 @@
+-- session_variable.exists()
+\set id random(0, :nr_variables - 1)
+select session_variable.exists('bench_int8_' || lpad(:id::text, 7, '0'));
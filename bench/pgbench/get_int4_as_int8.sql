@@ -0,0 +1,3 @@
+-- session_variable.get() of an integer variable as bigint (cast function)
+\set id random(0, :nr_variables - 1)
+select session_variable.get('bench_int4_' || lpad(:id::text, 7, '0'), null::bigint);
@@ -0,0 +1,3 @@
+-- session_variable.get() of a bigint variable as text (coerce via io)
+\set id random(0, :nr_variables - 1)
+select session_variable.get('bench_int8_' || lpad(:id::text, 7, '0'), null::text);
@@ -0,0 +1,3 @@
+-- session_variable.get() of a text variable as text (relabel, varlena)
+\set id random(0, :nr_variables - 1)
+select session_variable.get('bench_text_' || lpad(:id::text, 7, '0'), null::text);
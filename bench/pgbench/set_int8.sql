@@ -0,0 +1,3 @@
+-- session_variable.set() of a bigint variable
+\set id random(0, :nr_variables - 1)
+select session_variable.set('bench_int8_' || lpad(:id::text, 7, '0'), :id::bigint);
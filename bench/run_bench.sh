@@ -0,0 +1,157 @@
+#!/usr/bin/env bash
+#
+# Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+#
+# This program is free software: You may redistribute and/or modify under the
+# terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at Client's option) any
+# later version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+#
+#
+# Runs the session_variable micro benchmarks against a temporary instance and
+# writes the results as CSV to the file named by the first argument (default
+# bench_output.txt).
+#
+# The session_variable and session_variable_bench extensions must have been
+# installed in the PostgreSQL installation of PG_CONFIG:
+#     make install && make -C bench install
+#
+# Environment variables, next to the ones in bench/instance.sh:
+#     BENCH_VARIABLE_COUNTS  numbers of variables (default "10 1000 100000 1000000")
+#     BENCH_VALUE_SIZES      sizes in bytes of text values (default "16 256 4096 65536")
+#     BENCH_ITERATIONS       calls per loop driver measurement (default 1000000)
+#     BENCH_DURATION         seconds per pgbench measurement, 0 skips pgbench (default 10)
+#     BENCH_CLIENTS          pgbench clients (default 1)
+#
+# Output columns:
+#     tool           driver (C loop, no SQL overhead) or pgbench (one statement per call)
+#     operation      get, set, exists, reload or api_get (C interface)
+#     variables      number of variables of each kind in the catalog
+#     value_size     size in bytes of the variable value
+#     type           type of the variable
+#     coercion_path  relabel, func or io
+#     iterations     number of calls measured
+#     seconds        elapsed time
+#     ops_per_sec    calls per second
+#     ns_per_op      average latency in nanoseconds
+#
+
+set -euo pipefail
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+OUTPUT=${1:-bench_output.txt}
+VARIABLE_COUNTS=${BENCH_VARIABLE_COUNTS:-10 1000 100000 1000000}
+VALUE_SIZES=${BENCH_VALUE_SIZES:-16 256 4096 65536}
+ITERATIONS=${BENCH_ITERATIONS:-1000000}
+DURATION=${BENCH_DURATION:-10}
+CLIENTS=${BENCH_CLIENTS:-1}
+
+. "$BENCH_DIR/instance.sh"
+
+#
+# driver_row <operation> <variables> <value_size> <type> <coercion_path> <driver call>
+#
+# Runs the loop driver in a new session. The first call of the session is an
+# init() so the catalog load is not part of the measurement.
+#
+driver_row() {
+    local operation=$1 variables=$2 size=$3 type=$4 path=$5 call=$6
+    sql <<EOF
+select session_variable.init() \\g /dev/null
+select format('driver,%s,%s,%s,%s,%s,%s,%s,%s,%s', '$operation', $variables, $size, '$type', '$path',
+              $ITERATIONS, round(seconds::numeric, 6), round($ITERATIONS / seconds), round(seconds * 1e9 / $ITERATIONS))
+from (select session_variable_bench.$call as seconds) measurement;
+EOF
+}
+
+#
+# pgbench_row <operation> <variables> <value_size> <type> <coercion_path> <script>
+#
+pgbench_row() {
+    local operation=$1 variables=$2 size=$3 type=$4 path=$5 script=$6
+    local result transactions tps
+    result=$("$BINDIR/pgbench" -n -f "$BENCH_DIR/pgbench/$script" -D nr_variables="$variables" \
+             -c "$CLIENTS" -j "$CLIENTS" -T "$DURATION" 2>/dev/null)
+    transactions=$(sed -n 's/^number of transactions actually processed: \([0-9]*\).*/\1/p' <<<"$result")
+    tps=$(sed -n 's/^tps = \([0-9.]*\).*/\1/p' <<<"$result" | head -1)
+    awk -v op="$operation" -v n="$variables" -v size="$size" -v type="$type" -v path="$path" \
+        -v tx="$transactions" -v duration="$DURATION" -v tps="$tps" -v clients="$CLIENTS" \
+        'BEGIN { printf "pgbench,%s,%s,%s,%s,%s,%s,%s,%.0f,%.0f\n", op, n, size, type, path, tx, duration, tps, clients * 1e9 / tps }'
+}
+
+#
+# populate <prefix> <type> <count> <initial value expression of i>
+#
+populate() {
+    sql <<EOF
+insert into session_variable.variables
+       (variable_name, is_constant, variable_type_namespace, variable_type_name, initial_value)
+select '$1' || lpad(i::text, 7, '0'), false, 'pg_catalog', '$2', $4
+from generate_series(0, $3 - 1) i;
+EOF
+}
+
+start_instance
+
+echo "tool,operation,variables,value_size,type,coercion_path,iterations,seconds,ops_per_sec,ns_per_op" >"$OUTPUT"
+
+#
+# Latency against the number of variables in the catalog
+#
+for n in $VARIABLE_COUNTS; do
+    sql -c "truncate session_variable.variables"
+    populate bench_int8_ int8 "$n" "i::text"
+    populate bench_int4_ int4 "$n" "i::text"
+    populate bench_text_ text "$n" "repeat('x', 32)"
+    sql -c "vacuum analyze session_variable.variables"
+
+    sql <<EOF >>"$OUTPUT"
+select session_variable.init() \\g /dev/null
+select format('driver,reload,%s,0,,,1,%s,%s,%s', $n, reload_max_time / 1000, round(1000 / nullif(reload_max_time, 0)), round(reload_max_time * 1e6))
+from session_variable.backend_stats();
+EOF
+
+    {
+        driver_row get "$n" 8 bigint relabel "bench_get('bench_int8_', $n, $ITERATIONS, null::bigint)"
+        driver_row get "$n" 4 integer func "bench_get('bench_int4_', $n, $ITERATIONS, null::bigint)"
+        driver_row get "$n" 8 bigint io "bench_get('bench_int8_', $n, $ITERATIONS, null::text)"
+        driver_row get "$n" 32 text relabel "bench_get('bench_text_', $n, $ITERATIONS, null::text)"
+        driver_row api_get "$n" 8 bigint relabel "bench_api_get('bench_int8_', $n, $ITERATIONS, null::bigint)"
+        driver_row set "$n" 8 bigint relabel "bench_set('bench_int8_', $n, $ITERATIONS, 42::bigint)"
+        driver_row set "$n" 4 integer func "bench_set('bench_int4_', $n, $ITERATIONS, 42::bigint)"
+        driver_row set "$n" 32 text relabel "bench_set('bench_text_', $n, $ITERATIONS, repeat('y', 32))"
+        driver_row exists "$n" 0 "" "" "bench_exists('bench_int8_', $n, $ITERATIONS)"
+
+        if [ "$DURATION" -gt 0 ]; then
+            pgbench_row get "$n" 8 bigint relabel get_int8.sql
+            pgbench_row get "$n" 4 integer func get_int4_as_int8.sql
+            pgbench_row get "$n" 8 bigint io get_int8_as_text.sql
+            pgbench_row get "$n" 32 text relabel get_text.sql
+            pgbench_row set "$n" 8 bigint relabel set_int8.sql
+            pgbench_row exists "$n" 0 "" "" exists.sql
+        fi
+    } >>"$OUTPUT"
+done
+
+#
+# Latency against the size of the value, with a small catalog
+#
+n=1000
+for size in $VALUE_SIZES; do
+    sql -c "truncate session_variable.variables"
+    populate bench_text_ text "$n" "repeat('x', $size)"
+
+    {
+        driver_row get "$n" "$size" text relabel "bench_get('bench_text_', $n, $ITERATIONS, null::text)"
+        driver_row set "$n" "$size" text relabel "bench_set('bench_text_', $n, $ITERATIONS, repeat('y', $size))"
+    } >>"$OUTPUT"
+done
+
+echo "results written to $OUTPUT"
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ * 
+ * This program is free software: You may redistribute and/or modify under the 
+ * terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at Client's option) any 
+ * later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+
+create function bench_get
+    ( name_prefix               text
+    , nr_variables              integer
+    , iterations                bigint
+    , just_for_result_type      anyelement
+    ) returns double precision
+    as 'MODULE_PATHNAME', 'bench_get' language C;
+comment on function bench_get(text, integer, bigint, anyelement) is
+    'Invokes session_variable.get() iterations times, cycling through the variables name_prefix0000000 .. name_prefix<nr_variables - 1>. Returns the elapsed seconds';
+
+create function bench_set
+    ( name_prefix               text
+    , nr_variables              integer
+    , iterations                bigint
+    , new_value                 anyelement
+    ) returns double precision
+    as 'MODULE_PATHNAME', 'bench_set' language C;
+comment on function bench_set(text, integer, bigint, anyelement) is
+    'Invokes session_variable.set() iterations times, cycling through the variables name_prefix0000000 .. name_prefix<nr_variables - 1>. Returns the elapsed seconds';
+
+create function bench_exists
+    ( name_prefix               text
+    , nr_variables              integer
+    , iterations                bigint
+    ) returns double precision
+    as 'MODULE_PATHNAME', 'bench_exists' language C;
+comment on function bench_exists(text, integer, bigint) is
+    'Invokes session_variable.exists() iterations times, cycling through the variables name_prefix0000000 .. name_prefix<nr_variables - 1>. Returns the elapsed seconds';
+
+create function bench_api_get
+    ( name_prefix               text
+    , nr_variables              integer
+    , iterations                bigint
+    , just_for_result_type      anyelement
+    ) returns double precision
+    as 'MODULE_PATHNAME', 'bench_api_get' language C;
+comment on function bench_api_get(text, integer, bigint, anyelement) is
+    'Reads the variables name_prefix0000000 .. name_prefix<nr_variables - 1> iterations times through the C interface of session_variable. Returns the elapsed seconds';
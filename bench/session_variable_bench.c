@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+
+/*
+ * Loop driver for the session_variable micro benchmarks.
+ *
+ * The functions in here invoke session_variable.get(), set() and exists()
+ * through the function manager in a tight loop, so the measured time is the
+ * cost of the extension itself without the parse/plan/execute overhead of a
+ * SQL statement per call. The security definer wrapper is included, just like
+ * it is when the functions are invoked from SQL. bench_api_get() measures the
+ * C interface of session_variable_api.h instead, as other extensions use it.
+ */
+
+#include "postgres.h"
+
+#include "catalog/pg_type.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "parser/parse_func.h"
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+
+#include "session_variable_api.h"
+
+PG_MODULE_MAGIC;
+
+/*
+ * The loop memory context is reset after this many calls
+ */
+#define RESET_INTERVAL 1024
+
+/*
+ * function prototypes
+ */
+Datum* makeNames(text* namePrefix, int nrNames);
+void prepareCall(FmgrInfo* flinfo, char* functionName, int nargs,
+		Oid* declaredArgTypes, Oid* actualArgTypes, Oid resultType);
+double runLoop(FmgrInfo* flinfo, int nargs, Datum* names, int nrNames,
+		int64 iterations, Datum value, bool valueIsNull);
+
+/*
+ * Builds the variable names <namePrefix>0000000 .. <namePrefix><nrNames - 1>
+ *
+ * @param text* namePrefix - The common start of the variable names
+ * @param int nrNames - The number of names to build
+ * @return Datum* - Array of nrNames text datums
+ */
+Datum* makeNames(text* namePrefix, int nrNames)
+{
+	char* prefix = text_to_cstring(namePrefix);
+	Datum* names;
+	int i;
+
+	if (nrNames <= 0)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("nr_variables must be positive"))));
+	}
+
+	names = palloc(nrNames * sizeof(Datum));
+	for (i = 0; i < nrNames; i++)
+	{
+		names[i] = CStringGetTextDatum(psprintf("%s%07d", prefix, i));
+	}
+	pfree(prefix);
+	return names;
+}
+
+/*
+ * Looks up function session_variable.<functionName>(<declaredArgTypes>) and
+ * prepares flinfo to invoke it. The actual argument types are passed in a
+ * FuncExpr in flinfo->fn_expr so that the polymorphic argument can be
+ * resolved by the invoked function.
+ *
+ * @param FmgrInfo* flinfo - Is filled
+ * @param char* functionName - Name of the function in schema session_variable
+ * @param int nargs - The number of arguments
+ * @param Oid* declaredArgTypes - The argument types in the function signature
+ * @param Oid* actualArgTypes - The argument types the function is invoked with
+ * @param Oid resultType - The actual result type
+ */
+void prepareCall(FmgrInfo* flinfo, char* functionName, int nargs,
+		Oid* declaredArgTypes, Oid* actualArgTypes, Oid resultType)
+{
+	List* args = NIL;
+	Oid functionOid;
+	int i;
+
+	functionOid = LookupFuncName(list_make2(makeString("session_variable"),
+			makeString(functionName)), nargs, declaredArgTypes, false);
+	for (i = 0; i < nargs; i++)
+	{
+		args = lappend(args, makeNullConst(actualArgTypes[i], -1, InvalidOid));
+	}
+
+	fmgr_info(functionOid, flinfo);
+	flinfo->fn_expr = (Node*) makeFuncExpr(functionOid, resultType, args,
+			InvalidOid, InvalidOid, COERCE_EXPLICIT_CALL);
+}
+
+/*
+ * Invokes the function in flinfo iterations times, cycling through names as
+ * first argument. If nargs is 2 then value is passed as second argument.
+ *
+ * @param FmgrInfo* flinfo - The function to invoke, see prepareCall()
+ * @param int nargs - 1 or 2
+ * @param Datum* names - The variable names to cycle through
+ * @param int nrNames - The number of entries in names
+ * @param int64 iterations - The number of invocations
+ * @param Datum value - The second argument
+ * @param bool valueIsNull - true if the second argument is null
+ * @return double - The elapsed time in seconds
+ */
+double runLoop(FmgrInfo* flinfo, int nargs, Datum* names, int nrNames,
+		int64 iterations, Datum value, bool valueIsNull)
+{
+	LOCAL_FCINFO(fcinfo, 2);
+	MemoryContext loopContext;
+	MemoryContext oldContext;
+	instr_time startTime;
+	instr_time duration;
+	int64 i;
+
+	if (iterations <= 0)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("iterations must be positive"))));
+	}
+
+	loopContext = AllocSetContextCreate(CurrentMemoryContext,
+			"session_variable_bench", ALLOCSET_DEFAULT_SIZES);
+	oldContext = MemoryContextSwitchTo(loopContext);
+
+	InitFunctionCallInfoData(*fcinfo, flinfo, nargs, InvalidOid, NULL, NULL);
+
+	INSTR_TIME_SET_CURRENT(startTime);
+	for (i = 0; i < iterations; i++)
+	{
+		fcinfo->args[0].value = names[i % nrNames];
+		fcinfo->args[0].isnull = false;
+		if (nargs > 1)
+		{
+			fcinfo->args[1].value = value;
+			fcinfo->args[1].isnull = valueIsNull;
+		}
+		fcinfo->isnull = false;
+		FunctionCallInvoke(fcinfo);
+
+		if (i % RESET_INTERVAL == RESET_INTERVAL - 1)
+		{
+			MemoryContextReset(loopContext);
+			CHECK_FOR_INTERRUPTS();
+		}
+	}
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, startTime);
+
+	MemoryContextSwitchTo(oldContext);
+	MemoryContextDelete(loopContext);
+
+	return INSTR_TIME_GET_DOUBLE(duration);
+}
+
+/*
+ * bench_get(name_prefix text, nr_variables integer, iterations bigint, just_for_result_type anyelement) returns double precision
+ *
+ * Invokes session_variable.get(<name>, null::<type of just_for_result_type>) iterations times
+ */
+PG_FUNCTION_INFO_V1(bench_get);
+PGDLLEXPORT Datum bench_get( PG_FUNCTION_ARGS)
+{
+	Oid resultType = get_fn_expr_argtype(fcinfo->flinfo, 3);
+	Oid declaredArgTypes[2] = {TEXTOID, ANYELEMENTOID};
+	Oid actualArgTypes[2] = {TEXTOID, resultType};
+	int64 iterations;
+	int nrNames;
+	Datum* names;
+	FmgrInfo flinfo;
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("name_prefix, nr_variables and iterations must be filled"))));
+	}
+	iterations = PG_GETARG_INT64(2);
+	nrNames = (int) Min(PG_GETARG_INT32(1), iterations);
+
+	names = makeNames(PG_GETARG_TEXT_PP(0), nrNames);
+	prepareCall(&flinfo, "get", 2, declaredArgTypes, actualArgTypes, resultType);
+
+	PG_RETURN_FLOAT8(runLoop(&flinfo, 2, names, nrNames, iterations, (Datum) 0, true));
+}
+
+/*
+ * bench_set(name_prefix text, nr_variables integer, iterations bigint, new_value anyelement) returns double precision
+ *
+ * Invokes session_variable.set(<name>, new_value) iterations times
+ */
+PG_FUNCTION_INFO_V1(bench_set);
+PGDLLEXPORT Datum bench_set( PG_FUNCTION_ARGS)
+{
+	Oid valueType = get_fn_expr_argtype(fcinfo->flinfo, 3);
+	Oid declaredArgTypes[2] = {TEXTOID, ANYELEMENTOID};
+	Oid actualArgTypes[2] = {TEXTOID, valueType};
+	int64 iterations;
+	int nrNames;
+	Datum* names;
+	FmgrInfo flinfo;
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("name_prefix, nr_variables and iterations must be filled"))));
+	}
+	iterations = PG_GETARG_INT64(2);
+	nrNames = (int) Min(PG_GETARG_INT32(1), iterations);
+
+	names = makeNames(PG_GETARG_TEXT_PP(0), nrNames);
+	prepareCall(&flinfo, "set", 2, declaredArgTypes, actualArgTypes, BOOLOID);
+
+	PG_RETURN_FLOAT8(runLoop(&flinfo, 2, names, nrNames, iterations,
+			PG_ARGISNULL(3) ? (Datum) 0 : PG_GETARG_DATUM(3), PG_ARGISNULL(3)));
+}
+
+/*
+ * bench_exists(name_prefix text, nr_variables integer, iterations bigint) returns double precision
+ *
+ * Invokes session_variable.exists(<name>) iterations times
+ */
+PG_FUNCTION_INFO_V1(bench_exists);
+PGDLLEXPORT Datum bench_exists( PG_FUNCTION_ARGS)
+{
+	Oid argTypes[1] = {TEXTOID};
+	int64 iterations;
+	int nrNames;
+	Datum* names;
+	FmgrInfo flinfo;
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("name_prefix, nr_variables and iterations must be filled"))));
+	}
+	iterations = PG_GETARG_INT64(2);
+	nrNames = (int) Min(PG_GETARG_INT32(1), iterations);
+
+	names = makeNames(PG_GETARG_TEXT_PP(0), nrNames);
+	prepareCall(&flinfo, "exists", 1, argTypes, argTypes, BOOLOID);
+
+	PG_RETURN_FLOAT8(runLoop(&flinfo, 1, names, nrNames, iterations, (Datum) 0, true));
+}
+
+/*
+ * bench_api_get(name_prefix text, nr_variables integer, iterations bigint, just_for_result_type anyelement) returns double precision
+ *
+ * Reads the variables iterations times through the get function of the C
+ * interface of session_variable, with handles that are looked up in advance
+ */
+PG_FUNCTION_INFO_V1(bench_api_get);
+PGDLLEXPORT Datum bench_api_get( PG_FUNCTION_ARGS)
+{
+	Oid resultType = get_fn_expr_argtype(fcinfo->flinfo, 3);
+	SessionVariableApi* api;
+	SessionVariableHandle** handles;
+	MemoryContext loopContext;
+	MemoryContext oldContext;
+	instr_time startTime;
+	instr_time duration;
+	int64 iterations;
+	int nrNames;
+	Datum* names;
+	Datum value;
+	bool isNull;
+	int64 i;
+
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1) || PG_ARGISNULL(2))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("name_prefix, nr_variables and iterations must be filled"))));
+	}
+	iterations = PG_GETARG_INT64(2);
+	if (iterations <= 0)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("iterations must be positive"))));
+	}
+	nrNames = (int) Min(PG_GETARG_INT32(1), iterations);
+
+	api = *(SessionVariableApi**) find_rendezvous_variable(
+			SESSION_VARIABLE_API_NAME);
+	if (api == NULL)
+	{
+		load_file("session_variable", false);
+		api = *(SessionVariableApi**) find_rendezvous_variable(
+				SESSION_VARIABLE_API_NAME);
+	}
+
+	names = makeNames(PG_GETARG_TEXT_PP(0), nrNames);
+	handles = palloc(nrNames * sizeof(SessionVariableHandle*));
+	for (i = 0; i < nrNames; i++)
+	{
+		handles[i] = api->lookup(TextDatumGetCString(names[i]));
+		if (handles[i] == NULL)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_NO_DATA), (errmsg("variable \"%s\" does not exists", TextDatumGetCString(names[i])))));
+		}
+	}
+
+	loopContext = AllocSetContextCreate(CurrentMemoryContext,
+			"session_variable_bench", ALLOCSET_DEFAULT_SIZES);
+	oldContext = MemoryContextSwitchTo(loopContext);
+
+	INSTR_TIME_SET_CURRENT(startTime);
+	for (i = 0; i < iterations; i++)
+	{
+		api->get(handles[i % nrNames], resultType, &value, &isNull);
+
+		if (i % RESET_INTERVAL == RESET_INTERVAL - 1)
+		{
+			MemoryContextReset(loopContext);
+			CHECK_FOR_INTERRUPTS();
+		}
+	}
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, startTime);
+
+	MemoryContextSwitchTo(oldContext);
+	MemoryContextDelete(loopContext);
+
+	PG_RETURN_FLOAT8(INSTR_TIME_GET_DOUBLE(duration));
+}
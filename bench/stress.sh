@@ -0,0 +1,148 @@
+#!/usr/bin/env bash
+#
+# Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+#
+# This program is free software: You may redistribute and/or modify under the
+# terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at Client's option) any
+# later version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+#
+#
+# Large catalog stress test. Creates catalogs of increasing size with
+# session_variable.create_variable() in insertion orders that degrade an
+# unbalanced binary tree, and measures for each catalog:
+#  - the creation time per variable and the tree depth in the creating session
+#  - the latency of the first call in a fresh session, which loads the catalog
+#  - the reload() time and the tree depth after the load
+#  - the latency of a lookup
+# The results are written as CSV to the file named by the first argument
+# (default stress_output.txt). The script fails if a tree is deeper than
+# expected or if a measurement grows faster than expected between two catalog
+# sizes.
+#
+# The session_variable and session_variable_bench extensions must have been
+# installed in the PostgreSQL installation of PG_CONFIG:
+#     make install && make -C bench install
+#
+# Environment variables, next to the ones in bench/instance.sh:
+#     STRESS_VARIABLE_COUNTS  increasing catalog sizes (default "10000 100000 200000")
+#     STRESS_ORDERS           insertion orders, from ascending, descending, zigzag
+#                             and random (default all)
+#     STRESS_LOOKUPS          lookups per latency measurement (default 1000000)
+#     STRESS_GROWTH_SLACK     factor by which a measurement may grow more than
+#                             its expected complexity (default 3)
+#
+# Expected complexity:
+#     creation per variable, lookup   O(log(n))
+#     first call, reload              O(n)
+#     tree depth while creating       at most log1.5(n) + 1 levels
+#     tree depth after reload         at most log2(n) + 1 levels
+#
+
+set -euo pipefail
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+OUTPUT=${1:-stress_output.txt}
+VARIABLE_COUNTS=${STRESS_VARIABLE_COUNTS:-10000 100000 200000}
+ORDERS=${STRESS_ORDERS:-ascending descending zigzag random}
+LOOKUPS=${STRESS_LOOKUPS:-1000000}
+SLACK=${STRESS_GROWTH_SLACK:-3}
+FAILURES=0
+
+. "$BENCH_DIR/instance.sh"
+
+#
+# id_expression <order> <count>
+#
+# The variable number to create at position g of the insertion order
+#
+id_expression() {
+    case $1 in
+        ascending)  echo "g" ;;
+        descending) echo "$2 - 1 - g" ;;
+        zigzag)     echo "case when g % 2 = 0 then g / 2 else $2 - 1 - g / 2 end" ;;
+        random)     echo "g" ;;
+        *)          echo "unknown insertion order $1" >&2; exit 2 ;;
+    esac
+}
+
+order_by() {
+    if [ "$1" = random ]; then echo "random()"; else echo "g"; fi
+}
+
+#
+# check <description> <awk condition>
+#
+check() {
+    if ! awk "BEGIN { exit !($2) }"; then
+        echo "FAILED: $1" >&2
+        FAILURES=$((FAILURES + 1))
+    fi
+}
+
+echo "order,variables,create_us_per_variable,create_tree_depth,first_call_us,reload_us,tree_depth,lookup_ns" >"$OUTPUT"
+
+for order in $ORDERS; do
+    previous=""
+    for n in $VARIABLE_COUNTS; do
+        sql -c "truncate session_variable.variables"
+
+        create=$(sql <<EOF
+select session_variable.init() \\g /dev/null
+select clock_timestamp() as t0 \\gset
+do \$\$
+begin
+    perform session_variable.create_variable('stress_' || lpad(id::text, 7, '0'), 'bigint'::regtype, id::bigint)
+    from (select $(id_expression "$order" "$n") as id from generate_series(0, $n - 1) g order by $(order_by "$order")) ids;
+end \$\$;
+select format('%s,%s', round(extract(epoch from clock_timestamp() - :'t0'::timestamptz) * 1e6 / $n, 3), tree_depth)
+from session_variable.backend_stats();
+EOF
+        )
+        sql -c "vacuum analyze session_variable.variables"
+
+        load=$(sql <<EOF
+select clock_timestamp() as t0 \\gset
+select session_variable.get('stress_0000000', null::bigint) \\g /dev/null
+select format('%s,%s,%s', round(extract(epoch from clock_timestamp() - :'t0'::timestamptz) * 1e6), round(reload_max_time * 1000), tree_depth)
+from session_variable.backend_stats();
+select round(session_variable_bench.bench_get('stress_', $n, $LOOKUPS, null::bigint) * 1e9 / $LOOKUPS, 1);
+EOF
+        )
+        row="$order,$n,$create,$(tr '\n' ',' <<<"$load" | sed 's/,$//')"
+        echo "$row" >>"$OUTPUT"
+        echo "$row"
+
+        IFS=, read -r _ _ create_us create_depth first_call_us reload_us depth lookup_ns <<<"$row"
+        check "$order $n: tree depth $create_depth while creating" \
+              "$create_depth <= int(log($n) / log(1.5)) + 1"
+        check "$order $n: tree depth $depth after reload" \
+              "$depth <= int(log($n) / log(2)) + 1"
+
+        if [ -n "$previous" ]; then
+            IFS=, read -r _ p_n p_create_us _ p_first_call_us p_reload_us _ p_lookup_ns <<<"$previous"
+            check "$order $p_n -> $n: creation per variable grew from $p_create_us to $create_us us" \
+                  "$create_us <= $SLACK * $p_create_us * log($n) / log($p_n)"
+            check "$order $p_n -> $n: first call grew from $p_first_call_us to $first_call_us us" \
+                  "$first_call_us <= $SLACK * $p_first_call_us * $n / $p_n"
+            check "$order $p_n -> $n: reload grew from $p_reload_us to $reload_us us" \
+                  "$reload_us <= $SLACK * $p_reload_us * $n / $p_n"
+            check "$order $p_n -> $n: lookup grew from $p_lookup_ns to $lookup_ns ns" \
+                  "$lookup_ns <= $SLACK * $p_lookup_ns * log($n) / log($p_n)"
+        fi
+        previous=$row
+    done
+done
+
+echo "results written to $OUTPUT"
+if [ "$FAILURES" -gt 0 ]; then
+    echo "$FAILURES checks failed" >&2
+    exit 1
+fi
@@ -0,0 +1,713 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ * 
+ * This program is free software: You may redistribute and/or modify under the 
+ * terms of the GNU General Public License as published by the Free Software 
+ * Foundation, either version 3 of the License, or (at Client's option) any 
+ * later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with 
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+
+do $$
+begin
+    if not exists (
+        select role_name
+        from information_schema.enabled_roles
+        where role_name = 'session_variable_user_role')
+    then
+        create role session_variable_user_role;
+    end if;
+    if not exists (
+        select role_name
+        from information_schema.enabled_roles
+        where role_name = 'session_variable_administrator_role')
+    then
+        create role session_variable_administrator_role
+            in role session_variable_user_role;
+    end if;
+end; $$;
+
+comment on schema session_variable is 'Belongs to the session_variable extension';
+grant usage on schema session_variable to session_variable_user_role;
+
+do $$
+begin
+    if not exists ( select * 
+                    from pg_catalog.pg_class rel
+                    join pg_catalog.pg_namespace nsp on nsp.oid = rel.relnamespace
+                    where rel.relname = 'variables'
+                      and nsp.nspname = 'session_variable'
+                  ) then
+        create table variables 
+        (  variable_name                text          not null 
+                                                      primary key
+                                                      collate "C"
+        ,  created_timestamp            timestamp     not null
+        ,  created_by                   text          not null
+        ,  last_updated_timestamp       timestamp     not null
+        ,  last_updated_by              text          not null
+        ,  is_constant                  boolean       not null
+        ,  variable_type_namespace      name          not null
+        ,  variable_type_name           name          not null
+        ,  initial_value                text
+        ,  variable_scope               text          not null
+                                                      default 'session'
+                                                      check (variable_scope in ('session', 'transaction'))
+        ,  check (variable_scope = 'session' or not is_constant)
+        );
+    end if;
+end; $$;
+select pg_catalog.pg_extension_config_dump('variables', '');
+comment on table variables is 'holds constant values and the initial values of session variables';
+
+create function variables_bi()
+returns trigger as
+$body$
+begin
+    new.created_timestamp = current_timestamp;
+    new.last_updated_timestamp = current_timestamp;
+    new.created_by = session_user;
+    new.last_updated_by = session_user;
+    return new;
+end;
+$body$
+language plpgsql
+security definer;
+drop trigger if exists variables_bi on variables;
+create trigger variables_bi
+before insert on variables 
+for each row execute procedure variables_bi();
+
+create function variables_bu()
+returns trigger as
+$body$
+begin
+    new.last_updated_timestamp = current_timestamp;
+    new.last_updated_by = session_user;
+    return new;
+end;
+$body$
+language plpgsql
+security definer;
+drop trigger if exists variables_bu on variables;
+create trigger variables_bu
+before update on variables 
+for each row execute procedure variables_bu();
+
+create table variable_overrides
+(  variable_name                text          not null
+                                              collate "C"
+,  role_name                    name
+,  application_name             text
+,  initial_value                text
+,  check (role_name is not null or application_name is not null)
+);
+create unique index variable_overrides_uk
+    on variable_overrides (variable_name, coalesce(role_name, ''), coalesce(application_name, ''));
+select pg_catalog.pg_extension_config_dump('variable_overrides', '');
+comment on table variable_overrides is 'holds initial values of constants and session variables for sessions of a role and/or with an application_name';
+grant select, insert, update, delete on variable_overrides
+    to session_variable_administrator_role;
+
+create function variable_overrides_biu()
+returns trigger as
+$body$
+declare
+    var_rec record;
+begin
+    select variable_type_namespace, variable_type_name
+    into var_rec
+    from session_variable.variables
+    where variable_name = new.variable_name;
+    if not found
+    then
+        raise exception 'variable or constant "%" does not exists', new.variable_name
+            using errcode = 'no_data';
+    end if;
+    if new.initial_value is not null
+    then
+        execute format('select %L::%I.%I', new.initial_value,
+                       var_rec.variable_type_namespace, var_rec.variable_type_name);
+    end if;
+    return new;
+end;
+$body$
+language plpgsql
+security definer;
+create trigger variable_overrides_biu
+before insert or update on variable_overrides 
+for each row execute procedure variable_overrides_biu();
+
+create function variables_ad()
+returns trigger as
+$body$
+begin
+    delete from session_variable.variable_overrides
+    where variable_name = old.variable_name;
+    return old;
+end;
+$body$
+language plpgsql
+security definer;
+create trigger variables_ad
+after delete on variables 
+for each row execute procedure variables_ad();
+
+create function catalog_changed()
+returns trigger
+    as 'session_variable', 'catalog_changed' language C;
+comment on function catalog_changed() is
+    'lets new sessions load the changed catalog instead of the one preloaded for session_variable.preload_database';
+create trigger variables_changed
+after insert or update or delete or truncate on variables
+for each statement execute procedure catalog_changed();
+create trigger variable_overrides_changed
+after insert or update or delete or truncate on variable_overrides
+for each statement execute procedure catalog_changed();
+
+create function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    ) returns boolean
+    as 'session_variable', 'create_variable' language C security definer;
+comment on function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    ) is 'create a session variable with null as initial value';
+grant execute on function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    )
+    to session_variable_administrator_role;     
+
+create function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    ,   initial_value               anyelement
+    ) returns boolean
+    as 'session_variable', 'create_variable' language C security definer;
+comment on function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    ,   initial_value               anyelement
+    ) is 'create a session variable with initial value';
+grant execute on function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    ,   initial_value               anyelement
+    )
+    to session_variable_administrator_role;
+
+create function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    ,   initial_value               anyelement
+    ,   variable_scope              text
+    ) returns boolean
+    as 'session_variable', 'create_variable' language C security definer;
+comment on function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    ,   initial_value               anyelement
+    ,   variable_scope              text
+    ) is 'create a session variable with initial value that is reset at the end of each transaction if variable_scope is ''transaction''';
+grant execute on function create_variable
+    (   variable_name               text
+    ,   variable_type               regtype
+    ,   initial_value               anyelement
+    ,   variable_scope              text
+    )
+    to session_variable_administrator_role;
+
+create function create_constant
+    (   constant_name               text
+    ,   constant_type               regtype
+    ,   constant_value              anyelement
+    ) returns boolean
+    as 'session_variable', 'create_constant' language C security definer;
+comment on function create_constant
+    (   constant_name               text
+    ,   constant_type               regtype
+    ,   constant_value              anyelement
+    ) is 'create a constant';
+grant execute on function create_constant
+    (   constant_name               text
+    ,   constant_type               regtype
+    ,   constant_value              anyelement
+    )
+    to session_variable_administrator_role;
+
+create type variable_definition as
+    (   variable_name               text
+    ,   variable_type               regtype
+    ,   is_constant                 boolean
+    ,   initial_value               text
+    );
+comment on type variable_definition is
+    'definition of a constant or session variable for import()';
+grant usage on type variable_definition to session_variable_administrator_role;
+
+create function import(definitions variable_definition[])
+    returns integer
+    as 'session_variable', 'import' language C security definer;
+comment on function import(definitions variable_definition[])
+    is 'create constants and session variables in bulk, initial values are in text format';
+grant execute on function import(definitions variable_definition[])
+    to session_variable_administrator_role;
+
+create function alter_value
+    (   variable_or_constant_name   text
+    ,   variable_or_constant_value  anyelement
+    ) returns boolean
+    as 'session_variable', 'alter_value' language C security definer;
+comment on function alter_value
+    (   variable_or_constant_name   text
+    ,   variable_or_constant_value  anyelement
+    ) is 'alter the value of a constant or the initial value of a session variable';
+grant execute on function alter_value
+    (   variable_or_constant_name   text
+    ,   variable_or_constant_value  anyelement
+    )
+    to session_variable_administrator_role;
+
+create function drop(variable_or_constant_name text)
+    returns boolean
+    as 'session_variable', 'drop' language C security definer;
+comment on function drop(variable_or_constant_name text)
+    is 'drop the constant or the session variable with the specified name';
+grant execute on function drop(variable_or_constant_name text)
+    to session_variable_administrator_role;
+
+create function get
+    ( variable_or_constant_name text
+    , just_for_result_type anyelement
+    )
+    returns anyelement
+    as 'session_variable', 'get' language C security definer cost 2 parallel safe;
+comment on function get
+    ( variable_or_constant_name text
+    , just_for_result_type anyelement
+    ) is 'Get the content of a constant or a session variable';
+grant execute on function get
+    ( variable_or_constant_name text
+    , just_for_result_type anyelement
+    )
+    to session_variable_user_role;
+
+create function get_stable_support(internal)
+    returns internal
+    as 'session_variable', 'get_stable_support' language C;
+comment on function get_stable_support(internal) is
+    'Planner support function for get_stable(text, anyelement)';
+
+create function get_stable
+    ( variable_or_constant_name text
+    , just_for_result_type anyelement
+    )
+    returns anyelement stable
+    as 'session_variable', 'get' language C security definer cost 2
+    parallel safe support get_stable_support;
+comment on function get_stable
+    ( variable_or_constant_name text
+    , just_for_result_type anyelement
+    ) is 'Same as get(text, anyelement) but marked as STABLE so the result may be cached';
+grant execute on function get_stable
+    ( variable_or_constant_name text
+    , just_for_result_type anyelement
+    )
+    to session_variable_user_role;
+
+create function get_constant
+    ( constant_name text
+    , just_for_result_type anyelement
+    )
+    returns anyelement immutable
+    as 'session_variable', 'get_constant' language C security definer cost 2 parallel safe;
+comment on function get_constant
+    ( variable_or_constant_name text
+    , just_for_result_type anyelement
+    ) is 'Get the content of a constant. Marked IMMUTABLE so the result may be cached';
+grant execute on function get_constant
+    ( variable_or_constant_name text
+    , just_for_result_type anyelement
+    )
+    to session_variable_user_role;
+
+create function set(variable_name text, new_value anyelement)
+    returns boolean 
+    as 'session_variable', 'set' language C security definer cost 2;
+comment on function set(variable_name text, new_value anyelement) is
+    'Update the value of a session variable. The changed value will be visible in the curent session only';
+grant execute on function set(variable_name text, new_value anyelement)
+    to session_variable_user_role;
+
+create function get_int4(variable_or_constant_name text)
+    returns integer
+    as 'session_variable', 'get_int4' language C security definer cost 1 parallel safe;
+comment on function get_int4(variable_or_constant_name text) is
+    'Get the content of a constant or a session variable as integer';
+grant execute on function get_int4(variable_or_constant_name text)
+    to session_variable_user_role;
+
+create function get_int8(variable_or_constant_name text)
+    returns bigint
+    as 'session_variable', 'get_int8' language C security definer cost 1 parallel safe;
+comment on function get_int8(variable_or_constant_name text) is
+    'Get the content of a constant or a session variable as bigint';
+grant execute on function get_int8(variable_or_constant_name text)
+    to session_variable_user_role;
+
+create function get_bool(variable_or_constant_name text)
+    returns boolean
+    as 'session_variable', 'get_bool' language C security definer cost 1 parallel safe;
+comment on function get_bool(variable_or_constant_name text) is
+    'Get the content of a constant or a session variable as boolean';
+grant execute on function get_bool(variable_or_constant_name text)
+    to session_variable_user_role;
+
+create function get_text(variable_or_constant_name text)
+    returns text
+    as 'session_variable', 'get_text' language C security definer cost 1 parallel safe;
+comment on function get_text(variable_or_constant_name text) is
+    'Get the content of a constant or a session variable as text';
+grant execute on function get_text(variable_or_constant_name text)
+    to session_variable_user_role;
+
+create function get_uuid(variable_or_constant_name text)
+    returns uuid
+    as 'session_variable', 'get_uuid' language C security definer cost 1 parallel safe;
+comment on function get_uuid(variable_or_constant_name text) is
+    'Get the content of a constant or a session variable as uuid';
+grant execute on function get_uuid(variable_or_constant_name text)
+    to session_variable_user_role;
+
+create function get_timestamptz(variable_or_constant_name text)
+    returns timestamp with time zone
+    as 'session_variable', 'get_timestamptz' language C security definer cost 1 parallel safe;
+comment on function get_timestamptz(variable_or_constant_name text) is
+    'Get the content of a constant or a session variable as timestamp with time zone';
+grant execute on function get_timestamptz(variable_or_constant_name text)
+    to session_variable_user_role;
+
+create function set_int4(variable_name text, new_value integer)
+    returns boolean
+    as 'session_variable', 'set_int4' language C security definer cost 1;
+comment on function set_int4(variable_name text, new_value integer) is
+    'Update the value of a session variable, passing the new value as integer';
+grant execute on function set_int4(variable_name text, new_value integer)
+    to session_variable_user_role;
+
+create function set_int8(variable_name text, new_value bigint)
+    returns boolean
+    as 'session_variable', 'set_int8' language C security definer cost 1;
+comment on function set_int8(variable_name text, new_value bigint) is
+    'Update the value of a session variable, passing the new value as bigint';
+grant execute on function set_int8(variable_name text, new_value bigint)
+    to session_variable_user_role;
+
+create function set_bool(variable_name text, new_value boolean)
+    returns boolean
+    as 'session_variable', 'set_bool' language C security definer cost 1;
+comment on function set_bool(variable_name text, new_value boolean) is
+    'Update the value of a session variable, passing the new value as boolean';
+grant execute on function set_bool(variable_name text, new_value boolean)
+    to session_variable_user_role;
+
+create function set_text(variable_name text, new_value text)
+    returns boolean
+    as 'session_variable', 'set_text' language C security definer cost 1;
+comment on function set_text(variable_name text, new_value text) is
+    'Update the value of a session variable, passing the new value as text';
+grant execute on function set_text(variable_name text, new_value text)
+    to session_variable_user_role;
+
+create function set_uuid(variable_name text, new_value uuid)
+    returns boolean
+    as 'session_variable', 'set_uuid' language C security definer cost 1;
+comment on function set_uuid(variable_name text, new_value uuid) is
+    'Update the value of a session variable, passing the new value as uuid';
+grant execute on function set_uuid(variable_name text, new_value uuid)
+    to session_variable_user_role;
+
+create function set_timestamptz(variable_name text, new_value timestamp with time zone)
+    returns boolean
+    as 'session_variable', 'set_timestamptz' language C security definer cost 1;
+comment on function set_timestamptz(variable_name text, new_value timestamp with time zone) is
+    'Update the value of a session variable, passing the new value as timestamp with time zone';
+grant execute on function set_timestamptz(variable_name text, new_value timestamp with time zone)
+    to session_variable_user_role;
+
+create function "exists"(variable_name text) 
+    returns boolean
+    as 'session_variable', 'exists' language C security definer cost 2 parallel safe;
+comment on function "exists"(variable_name text) is
+    'Checks if a constant or session variable with the specified name exists';
+grant execute on function "exists"(variable_name text)
+    to session_variable_user_role;
+    
+create function type_of(variable_or_constant_name text)
+    returns regtype
+    as 'session_variable', 'type_of' language C security definer cost 2 parallel safe;
+comment on function type_of(variable_or_constant_name text) is
+    'Returns the datatype of the value of the specified constant or session variable'; 
+grant execute on function type_of(variable_or_constant_name text)
+    to session_variable_user_role;
+    
+create function is_constant(variable_or_constant_name text)
+    returns boolean
+    as 'session_variable', 'is_constant' language C security definer cost 2 parallel safe;
+comment on function is_constant(variable_or_constant_name text) is
+    'Returns true if the specified constant or variable appears to be a constant'
+    ' or false if it happens to be a session variable'; 
+grant execute on function is_constant(variable_or_constant_name text)
+    to session_variable_user_role;
+
+create function init()
+    returns integer
+    as 'session_variable', 'init' language C security definer;
+comment on function init() is 
+    'Reloads all constants and session variables from the variables table, thus reverting all local changes';
+
+create function init_worker()
+    returns void
+    as 'session_variable', 'init_worker' language C security definer;
+comment on function init_worker() is 
+    'Prepares a background worker for the use of constants and session variables, which are (re)loaded from the variables table when they are used next';
+
+create function backend_stats
+    ( out get_calls                 bigint
+    , out set_calls                 bigint
+    , out exists_calls              bigint
+    , out reload_calls              bigint
+    , out reload_total_time         double precision
+    , out reload_max_time           double precision
+    , out nr_variables              integer
+    , out name_bytes                bigint
+    , out value_bytes               bigint
+    , out tree_depth                integer
+    , out relabel_coercions         bigint
+    , out func_coercions            bigint
+    , out io_coercions              bigint
+    , out coercion_cache_hits       bigint
+    , out preloaded_reloads         bigint
+    )
+    returns record
+    as 'session_variable', 'backend_stats' language C;
+comment on function backend_stats() is 
+    'Returns the usage counters and memory usage of session_variable in the current session. Times are in milliseconds';
+grant execute on function backend_stats() 
+    to session_variable_user_role;
+
+create function current_values
+    ( include_text                  boolean default true
+    , out variable_name             text
+    , out variable_type             regtype
+    , out is_constant               boolean
+    , out is_modified               boolean
+    , out value_text                text
+    , out value_bytes               integer
+    )
+    returns setof record
+    as 'session_variable', 'current_values' language C security definer;
+comment on function current_values(boolean) is 
+    'Returns all variables and constants of the current session with their current values, the values are converted to text only if include_text is true';
+grant execute on function current_values(boolean) 
+    to session_variable_user_role;
+
+create function changes_since
+    ( since_sequence                bigint
+    , out variable_name             text
+    , out variable_type             regtype
+    , out is_constant               boolean
+    , out value_text                text
+    , out modification_sequence     bigint
+    )
+    returns setof record
+    as 'session_variable', 'changes_since' language C security definer;
+comment on function changes_since(bigint) is 
+    'Returns the variables and constants of the current session that have been loaded or changed after since_sequence with their current values';
+grant execute on function changes_since(bigint) 
+    to session_variable_user_role;
+
+create function version(variable_or_constant_name text)
+    returns bigint
+    as 'session_variable', 'version' language C security definer cost 2;
+comment on function version(variable_or_constant_name text) is
+    'Returns a number that is higher after every change of the specified constant or session variable in the current session';
+grant execute on function version(variable_or_constant_name text)
+    to session_variable_user_role;
+
+create function export_state()
+    returns bytea
+    as 'session_variable', 'export_state' language C security definer;
+comment on function export_state() is 
+    'Returns the values of all variables of the current session in binary form, to be passed to import_state() in another session of the same database';
+grant execute on function export_state() 
+    to session_variable_user_role;
+
+create function import_state(state bytea)
+    returns integer
+    as 'session_variable', 'import_state' language C security definer;
+comment on function import_state(bytea) is 
+    'Sets the variables of the current session to the values in state as returned by export_state(). Returns the number of variables set';
+grant execute on function import_state(bytea) 
+    to session_variable_user_role;
+
+create function set_rows(variable_name text, query text)
+    returns bigint
+    as 'session_variable', 'set_rows' language C;
+comment on function set_rows(variable_name text, query text) is
+    'Keeps the rows of the query as result set variable of the current session and returns their number, a null query removes the result set variable';
+grant execute on function set_rows(variable_name text, query text)
+    to session_variable_user_role;
+
+create function rows_support(internal)
+    returns internal
+    as 'session_variable', 'rows_support' language C;
+comment on function rows_support(internal) is
+    'Planner support function for rows(text, anyelement)';
+
+create function rows(variable_name text, row_type anyelement)
+    returns setof anyelement
+    as 'session_variable', 'rows' language C parallel restricted
+    support rows_support;
+comment on function rows(variable_name text, row_type anyelement) is
+    'Returns the rows of the result set variable as row_type';
+grant execute on function rows(variable_name text, row_type anyelement)
+    to session_variable_user_role;
+
+create function get_session_variable_version()
+    returns varchar
+    as 'session_variable', 'get_session_variable_version' language C security definer cost 1;
+comment on function get_session_variable_version() is 
+    'Reurns the version of the session_variable database extension';
+grant execute on function get_session_variable_version() 
+    to session_variable_user_role;
+
+create function is_executing_variable_initialisation()
+    returns boolean
+    as 'session_variable', 'is_executing_variable_initialisation' language C security definer cost 1;
+comment on function is_executing_variable_initialisation() is 
+    'Reurns true if a function called session_variable.variable_initialisation() currently being invoked on behalf of session_variable initialisation code';
+    
+create function session_variable.dump(do_truncate boolean default true)
+  returns setof text AS
+$$
+declare
+    var_cursor cursor is 
+        select variable_name
+			 , is_constant
+			 , var.variable_type_namespace
+			   || '.'
+			   || case
+			      when etyp.typname is not null
+			       and typ.typname ~ ('^_+' || etyp.typname || '$')
+			       then etyp.typname || '[]'
+			      else typ.typname 
+			      end type_name
+			 , initial_value  
+			 , variable_scope
+        from session_variable.variables var
+		join pg_catalog.pg_namespace nsp 
+		    on var.variable_type_namespace = nsp.nspname 
+        join pg_catalog.pg_type typ 
+            on typ.typnamespace = nsp.oid
+            and var.variable_type_name = typ.typname
+	    left join pg_catalog.pg_type etyp
+	        on typ.typelem = etyp.oid 
+        order by variable_name;
+    var_rec record;
+    sql     text;
+    var_content text;
+begin
+    if do_truncate
+    then
+        return next 'truncate table session_variable.variables;';
+    end if;
+    return next 'select session_variable.init();';
+    for var_rec in var_cursor loop
+        return next format ( 'select session_variable.create_'
+                              || case var_rec.is_constant 
+                                 when true then 'constant' 
+                                 else 'variable'
+                                 end
+                              || '(%L, %L::regtype, %L::%s'
+                              || case var_rec.variable_scope
+                                 when 'transaction' then ', ''transaction'')'
+                                 else ')'
+                                 end
+                              || case 
+                                 when do_truncate then ';'
+                                 else ' where not session_variable.exists(%L);'
+                                 end
+                           , var_rec.variable_name
+                           , var_rec.type_name
+                           , var_rec.initial_value
+                           , var_rec.type_name
+                           , var_rec.variable_name
+                           );
+    end loop;
+end;
+$$ language plpgsql;
+comment on function dump(do_truncate boolean) is 
+    'Reurns a create script for all constants and variables';
+grant execute on function dump(do_truncate boolean) 
+    to session_variable_administrator_role;
+    
+create function stats
+    ( out database_oid              oid
+    , out variable_name             text
+    , out get_calls                 bigint
+    , out set_calls                 bigint
+    , out relabel_coercions         bigint
+    , out func_coercions            bigint
+    , out io_coercions              bigint
+    , out bytes_returned            bigint
+    )
+    returns setof record
+    as 'session_variable', 'stats' language C;
+comment on function stats() is 
+    'Returns the usage of variables aggregated over all sessions in all databases. Needs session_variable in shared_preload_libraries';
+grant execute on function stats() 
+    to session_variable_user_role;
+
+create function stats_reset()
+    returns void
+    as 'session_variable', 'stats_reset' language C;
+comment on function stats_reset() is 
+    'Clears the shared statistics';
+grant execute on function stats_reset() 
+    to session_variable_administrator_role;
+
+create view stats as
+select var.variable_name
+     , var.is_constant
+     , coalesce(sta.get_calls, 0)           as get_calls
+     , coalesce(sta.set_calls, 0)           as set_calls
+     , coalesce(sta.relabel_coercions, 0)   as relabel_coercions
+     , coalesce(sta.func_coercions, 0)      as func_coercions
+     , coalesce(sta.io_coercions, 0)        as io_coercions
+     , coalesce(sta.bytes_returned, 0)      as bytes_returned
+from session_variable.variables var
+left join session_variable.stats() sta
+    on sta.database_oid = ( select oid
+                            from pg_catalog.pg_database
+                            where datname = pg_catalog.current_database()
+                          )
+   and sta.variable_name collate "C" = var.variable_name;
+comment on view stats is
+    'Usage of the variables of this database, aggregated over all sessions since the last stats_reset()';
+grant select on stats to session_variable_user_role;
+
+revoke all on all functions in schema session_variable from public;
+grant execute on function init() to public;
+grant execute on function init_worker() to public;
+grant execute on function is_executing_variable_initialisation() 
+    to public;
@@ -17,25 +17,73 @@
 
 #include "postgres.h"
 
+#include "access/hash.h"
 #include "access/htup_details.h"
+#include "access/parallel.h"
+#if PG_VERSION_NUM >= 140000
+#include "access/toast_compression.h"
+#include "access/toast_internals.h"
+#elif PG_VERSION_NUM >= 130000
+#include "access/toast_internals.h"
+#else
+#include "access/tuptoaster.h"
+#endif
+#include "access/xact.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
+#include "commands/extension.h"
+#include "commands/trigger.h"
+#include "executor/executor.h"
 #include "executor/spi.h"
 #include "funcapi.h"
+#include "lib/stringinfo.h"
+#include "libpq/pqformat.h"
 #include "miscadmin.h"
+#include "pgstat.h"
+#include "pgtime.h"
+#include "postmaster/bgworker.h"
 #include "commands/dbcommands.h"
 #include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include <math.h>
 #include <sys/stat.h>
 #include "utils/builtins.h"
+#include "utils/bytea.h"
+#include "utils/datum.h"
+#include "utils/dsa.h"
+#include "utils/float.h"
 #include "utils/syscache.h"
 #include "utils/lsyscache.h"
+#include "nodes/makefuncs.h"
+#include "nodes/pathnodes.h"
+#include "nodes/supportnodes.h"
+#include "optimizer/optimizer.h"
 #include "parser/parse_coerce.h"
+#include "parser/parse_func.h"
+#include "portability/instr_time.h"
+#include "tcop/tcopprot.h"
 #include "utils/array.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+#include "utils/pg_locale.h"
+#include "utils/snapmgr.h"
+#include "utils/timestamp.h"
+#include "utils/tuplestore.h"
+#include "utils/varlena.h"
 
 #include "session_variable.h"
+#include "session_variable_api.h"
 
 #if PG_VERSION_NUM < 170000
 #define AmBackgroundWorkerProcess() (IsBackgroundWorker)
+#define DSA_HANDLE_INVALID ((dsa_handle) DSM_HANDLE_INVALID)
 #endif
 
 #ifdef PG_MODULE_MAGIC
@@ -45,35 +93,274 @@ PG_MODULE_MAGIC
 
 static bool virgin = true;
 static SessionVariable* variables = NULL;
+static int variableCount = 0;
 static bool pgInitInvoked = false;
 static bool isExecutingInitialisationFunction = false;
+static SessionVariableStatistics statistics;
+
+/*
+ * Compression of large values
+ */
+static int compressionThreshold = -1;
+static int compressionMethod = VALUE_COMPRESSION_PGLZ;
+static DecompressedValue decompressedValues[DECOMPRESSION_CACHE_SIZE];
+static int nextDecompressedValue = 0;
+static MemoryContext decompressionContext = NULL;
+static CoercedValue coercedValues[COERCION_CACHE_SIZE];
+static MemoryContext coercionContext = NULL;
+static CoercionSettings coercionSettings;
+static const struct config_enum_entry compressionMethodOptions[] = {
+	{"pglz", VALUE_COMPRESSION_PGLZ, false},
+#if PG_VERSION_NUM >= 140000 && defined(USE_LZ4)
+	{"lz4", VALUE_COMPRESSION_LZ4, false},
+#endif
+	{NULL, 0, false}
+};
+
+/*
+ * Shared statistics, only available when loaded via shared_preload_libraries
+ */
+static HTAB* sharedStatistics = NULL;
+static LWLock* sharedStatisticsLock = NULL;
+static int sharedStatisticsMax = 1000;
+static int sharedStatisticsFlushInterval = 10;
+static TimestampTz lastStatisticsFlush = 0;
+static bool statisticsCallbacksRegistered = false;
+
+/*
+ * Shared constants, only available when loaded via shared_preload_libraries
+ */
+static HTAB* sharedConstants = NULL;
+static LWLock* sharedConstantsLock = NULL;
+static SharedConstantsControl* sharedConstantsControl = NULL;
+static dsa_area* sharedConstantsArea = NULL;
+static int sharedConstantsMax = 1000;
+static SharedConstantChange* sharedConstantChanges = NULL;
+static bool sharedConstantsCallbacksRegistered = false;
+
+/*
+ * The catalog as loaded by the preload worker, only available when loaded via
+ * shared_preload_libraries with session_variable.preload_database set
+ */
+static char* preloadDatabase = NULL;
+static PreloadedCatalog* preloadedCatalog = NULL;
+static LWLock* preloadedCatalogLock = NULL;
+static dsa_area* preloadedCatalogArea = NULL;
+static bool catalogChanged = false; /* in the current transaction */
+static bool catalogCallbackRegistered = false;
+
+/*
+ * Shipping of the variables to the workers of a parallel query
+ */
+static char* parallelState = NULL;
+static char* shippedParallelState = NULL;
+static uint64 stateVersion = 0;
+static uint64 handleGeneration = 0; /* raised when variables are freed */
+static uint64 shippedStateVersion = 0;
+static uint64 shippedSharedConstantsVersion = 0;
+static ExecutorStart_hook_type previousExecutorStartHook = NULL;
+
+/*
+ * The session_variable.variables table of an extension that is installed in
+ * the version of this library, see isInstalledVersionCurrent()
+ */
+static Oid currentVariablesTableOid = InvalidOid;
+static bool installedVersionCallbackRegistered = false;
+
+/*
+ * Lazy loading of groups of variables
+ */
+static bool lazyLoadGroups = false;
+static LoadedGroup* loadedGroups = NULL;
+
+/*
+ * Writes to the session_variable.variables table that are deferred until the
+ * end of the transaction
+ */
+static bool deferWrites = false;
+static HTAB* pendingWrites = NULL;
+static bool pendingWritesCallbackRegistered = false;
+
+/*
+ * Variables that are bound to settings session_variable.<variable name>
+ */
+static char* boundVariables = NULL;
+static BoundSetting* boundSettings = NULL;
+static int nrBoundSettings = 0;
+static bool boundSettingsChanged = false;
+
+/*
+ * Transaction scoped variables that the current transaction has changed
+ */
+static TransactionScopedValue* transactionScopedValues = NULL;
+static bool transactionScopeCallbackRegistered = false;
+
+/*
+ * Result set variables of the session, see set_rows()
+ */
+static RowSet* rowSets = NULL;
+
+#if PG_VERSION_NUM >= 150000
+static shmem_request_hook_type previousShmemRequestHook = NULL;
+#endif
+static shmem_startup_hook_type previousShmemStartupHook = NULL;
 
 /*
  * function prototypes
  */
-void buildBTree(void);
+SessionVariableHandle* apiLookup(const char* variableName);
+bool apiGet(SessionVariableHandle* handle, Oid resultType, Datum* value,
+		bool* isNull);
+bool apiGetByName(const char* variableName, Oid resultType, Datum* value,
+		bool* isNull);
+bool apiSet(SessionVariableHandle* handle, Oid valueType, Datum value,
+		bool isNull);
+bool apiSetByName(const char* variableName, Oid valueType, Datum value,
+		bool isNull);
+uint64 apiChangeGeneration(void);
+bool apiGetVersion(SessionVariableHandle* handle, uint64* version);
+void applyBoundSettings(void);
+SessionVariable* applyPendingWrites(SessionVariable* list, char* name,
+		bool isPrefix, int* nrVariables);
+void applySharedConstantChange(SharedConstantChange* change);
+void assignBoundSetting(const char* newValue, void* extra);
+SessionVariable* buildBTree(SessionVariable* list);
+void collectTreeStatistics(SessionVariable* variable, int depth,
+		int* nrVariables, int* treeDepth, int64* nameBytes, int64* valueBytes);
+void checkInstalledVersion(void);
+void checkSerializedVariables(char* state, Size stateLength);
 bool checkTypeType(Oid typeOid);
+void catalogXactCallback(XactEvent event, void* arg);
+int compareImportDefinitions(const void* a, const void* b);
+int countNodes(SessionVariable* variable);
 Datum coerceInput(Oid inputType, Oid internalType, int internalTypeLength,
-		Datum input, bool* castFailed);
+		Datum input, char* inlineBuffer, bool* castFailed);
 Datum coerceOutput(Oid internalType, int internalTypeLength, Datum internalData,
-		Oid outputType, bool* castFailed);
+		Oid outputType, bool* castFailed, CoercionPathType* usedCoercionPath);
+void countGet(SessionVariable* variable, CoercionPathType coercionPath,
+		Oid resultTypeOid, bool isNull, Datum result);
+bool coercionSettingsChanged(void);
+Datum compressValue(Datum value);
 SessionVariable* createVariable(text* variableName, bool isConst, Oid valueType,
 		int typeLength, bool isNull, Datum value);
+bool deferWrite(PendingWriteType operation, char* variableName, bool isConst,
+		bool isTransactionScoped, Oid valueType, bool isNull, Datum value);
+void defineBoundSettings(void);
+void defineCompressionSettings(void);
+void defineDeferredWrites(void);
+void defineLazyLoading(void);
+void defineParallelState(void);
+void definePreloadedCatalog(void);
+void defineSharedConstants(void);
+void defineSharedMemory(void);
+void defineSharedStatistics(void);
 void deleteVariable(text* variablename);
 Datum deserializeV2(text* varName, Oid dataType, Datum detoastedValue);
+void executeDelete(char* variableName);
+bool executeInsert(char* variableName, bool isConst, bool isTransactionScoped,
+		Oid valueType, bool isNull, Datum value);
+void executeUpdate(char* variableName, bool isNull, Datum value);
+void exportVariables(SessionVariable* variable, StringInfo buffer);
+SessionVariable* flattenTree(SessionVariable* tree);
+void flushStatistics(void);
+void flushPendingWrites(void);
+RowSet* findRowSet(char* name);
+void freeContent(SessionVariable* variable);
+void flushStatisticsRecursively(SessionVariable* variable);
+void forgetAppliedSettings(void);
+void forgetCoercedValues(void);
+void forgetDecompressedValue(SessionVariable* variable);
+void forgetLoadedGroups(void);
+void forgetRowSet(char* name);
+void forgetRowSets(void);
+void forgetTransactionScopedValue(SessionVariable* variable);
+Datum getContent(SessionVariable* variable);
+Datum getCoercedValue(SessionVariable* variable, Oid resultTypeOid,
+		CoercionPathType* coercionPath);
+dsa_area* getPreloadedCatalogArea(void);
+dsa_area* getSharedConstantsArea(void);
 int getTypeLength(Oid typeOid);
+Datum getValue(SessionVariable* variable, Oid resultTypeOid, bool* isNull);
+VariableUsage* getUsage(SessionVariable* variable);
+void groupRange(char* prefix, Datum* args);
 bool insertVariable(SessionVariable* variable);
+bool isImmutableCoercion(Oid sourceType, Oid targetType,
+		CoercionPathType coercionPath);
+bool isInstalledVersionCurrent(void);
+void installedVersionRelcacheCallback(Datum arg, Oid relid);
+bool loadVariablesAsOwner(void);
 void invokeInitialisationFunction(void);
+bool loadGroup(char* variableName);
+SessionVariable* loadVariables(char* condition, int nrArgs, Datum* args,
+		int* nrVariables);
 void logVariable(int logLevel, char* leadingText, SessionVariable* variable);
+SessionVariable* mergeVariableLists(SessionVariable* list1,
+		SessionVariable* list2);
+void parallelStateExecutorStart(QueryDesc* queryDesc, int eflags);
+SessionVariable* pendingVariable(PendingWrite* write, bool isConst,
+		bool isTransactionScoped, Oid valueType);
+uint32 pendingWriteHash(const void* key, Size keySize);
+int pendingWriteMatch(const void* key1, const void* key2, Size keySize);
+void pendingWritesSubXactCallback(SubXactEvent event,
+		SubTransactionId mySubid, SubTransactionId parentSubid, void* arg);
+void pendingWritesXactCallback(XactEvent event, void* arg);
+void preloadCatalog(void);
+Size preloadedCatalogSize(void);
+PGDLLEXPORT void preloadWorkerMain(Datum argument);
+bool publishSharedConstant(SessionVariable* variable, Datum value,
+		Timestamp lastUpdated);
+void putChanges(SessionVariable* variable, uint64 sinceModification,
+		Tuplestorestate* tupleStore, TupleDesc tupleDesc);
+void putCurrentValues(SessionVariable* variable, bool includeText,
+		Tuplestorestate* tupleStore, TupleDesc tupleDesc);
+Datum readSharedConstant(SessionVariable* variable);
+void queueSharedConstantChange(char* constantName, bool isRemoval,
+		Timestamp lastUpdated);
+void rebalance(char* variableName);
+void rememberTransactionScopedValue(SessionVariable* variable);
 int reload(void);
+int restoreParallelState(void);
+bool restorePreloadedCatalog(SessionVariable** list, int* nrVariables);
+SessionVariable* restoreVariables(char* state, Size stateLength,
+		int* nrVariables);
 void removeVariableRecursively(SessionVariable* v);
-bool saveNewVariable(text* variableName, bool isConst, Oid valueType,
-		int typeLength, bool isNull, Datum value);
+SessionVariable* resolveHandle(SessionVariableHandle* handle);
+Node* replaceByInitPlan(PlannerInfo* root, FuncExpr* getStableCall);
+bool saveNewVariable(text* variableName, bool isConst,
+		bool isTransactionScoped, Oid valueType, int typeLength, bool isNull,
+		Datum value);
 SessionVariable* searchVariable(char* variableName, SessionVariable** lvl,
 		bool* found);
+bool setContent(SessionVariable* variable, Oid valueTypeOid, bool isNull,
+		Datum value);
+Datum getTypedContent(FunctionCallInfo fcinfo, Oid resultTypeOid,
+		char* functionName);
+Datum setTypedContent(FunctionCallInfo fcinfo, Oid valueTypeOid,
+		char* functionName);
 Datum serializeV2(SessionVariable* variable);
+void serializeVariables(SessionVariable* variable, StringInfo buffer);
+bool setValue(SessionVariable* variable, Oid valueTypeOid, bool isNull,
+		Datum value);
+void shipParallelState(void);
+#if PG_VERSION_NUM >= 150000
+void sharedMemoryShmemRequest(void);
+#endif
+void sharedMemoryShmemStartup(void);
+void shareContent(SessionVariable* variable, Timestamp lastUpdated);
+void sharedConstantsSubXactCallback(SubXactEvent event,
+		SubTransactionId mySubid, SubTransactionId parentSubid, void* arg);
+void sharedConstantsXactCallback(XactEvent event, void* arg);
+Size sharedConstantsSize(void);
+SharedConstantKey sharedConstantKey(char* constantName);
+Size sharedStatisticsSize(void);
+void statisticsShmemExit(int code, Datum arg);
+void statisticsXactCallback(XactEvent event, void* arg);
+void transactionScopeXactCallback(XactEvent event, void* arg);
+void unpublishSharedConstant(char* constantName);
+bool useSharedConstant(SessionVariable* variable, Timestamp lastUpdated);
 void updateRecursively(SessionVariable* var);
 void updateVariable(SessionVariable* variable);
+uint64 variableVersion(SessionVariable* variable);
 
 /*
  * Some fields to support both version 1 and version 2
@@ -83,15 +370,55 @@ Datum (*deserialize)(text* varName, Oid dataType,
 Datum (*serialize)(SessionVariable* variable) = &serializeV2;
 Oid initialValueTypeOid = TEXTOID;
 
+/*
+ * The C interface for other extensions, see session_variable_api.h
+ */
+static SessionVariableApi sessionVariableApi = {SESSION_VARIABLE_API_VERSION,
+		&apiLookup, &apiGet, &apiGetByName, &apiSet, &apiSetByName,
+		&apiChangeGeneration, &apiGetVersion};
+
 void _PG_init(void);
 void _PG_init()
+{
+	*find_rendezvous_variable(SESSION_VARIABLE_API_NAME) = &sessionVariableApi;
+
+	defineCompressionSettings();
+	defineLazyLoading();
+	defineDeferredWrites();
+	defineParallelState();
+	defineBoundSettings();
+
+	if (process_shared_preload_libraries_in_progress)
+	{
+		/*
+		 * Loaded in the postmaster, so there is no database to read from yet.
+		 */
+		defineSharedMemory();
+		return;
+	}
+
+	/*
+	 * A background worker may load the library before it connects to a
+	 * database, it invokes init_worker() instead
+	 */
+	if (AmBackgroundWorkerProcess())
+	{
+		return;
+	}
+	checkInstalledVersion();
+}
+
+/*
+ * Checks the installed version of the extension, once per process.
+ */
+void checkInstalledVersion(void)
 {
 	char* sql =
 			"select extversion from pg_extension where extname = 'session_variable'";
 	Portal cursor;
 	char* installedVersion;
 
-	if (AmBackgroundWorkerProcess() || pgInitInvoked)
+	if (pgInitInvoked)
 	{
 		return;
 	}
@@ -119,6 +446,78 @@ void _PG_init()
 	serialize = &serializeV2;
 	initialValueTypeOid = TEXTOID;
 }
+
+/*
+ * Checks if the extension is installed in the version of this library. A
+ * database in which the extension has not been updated yet lacks the tables
+ * and columns that were added later, like session_variable.variable_overrides.
+ * Only a current version is remembered, until the session_variable.variables
+ * table is altered or dropped, which updating the extension to this version
+ * or dropping it does. An older version is read again every time, because it
+ * changes when the extension is updated in the session.
+ *
+ * @return bool - true if the installed version is the version of the library
+ */
+bool isInstalledVersionCurrent(void)
+{
+	char* sql;
+	bool isCurrent = false;
+	bool isNull;
+	Oid namespaceOid;
+
+	if (OidIsValid(currentVariablesTableOid))
+	{
+		return true;
+	}
+
+	if (!installedVersionCallbackRegistered)
+	{
+		CacheRegisterRelcacheCallback(installedVersionRelcacheCallback,
+				(Datum) 0);
+		installedVersionCallbackRegistered = true;
+	}
+
+	sql = psprintf("select exists (select 1 from pg_catalog.pg_extension"
+			" where extname = 'session_variable' and extversion = '%s')",
+			sessionVariableVersion);
+	SPI_connect();
+	if (SPI_execute(sql, true, 1) == SPI_OK_SELECT && SPI_processed == 1)
+	{
+		isCurrent = DatumGetBool(
+				SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1,
+						&isNull));
+	}
+	SPI_finish();
+	pfree(sql);
+
+	if (isCurrent)
+	{
+		namespaceOid = get_namespace_oid("session_variable", true);
+		if (OidIsValid(namespaceOid))
+		{
+			currentVariablesTableOid = get_relname_relid("variables",
+					namespaceOid);
+		}
+	}
+	return isCurrent;
+}
+
+/*
+ * Relcache invalidation callback: forgets that the installed version is
+ * current when the session_variable.variables table changes, see
+ * isInstalledVersionCurrent()
+ *
+ * @param Datum arg - Not used
+ * @param Oid relid - The invalidated relation, InvalidOid for all
+ */
+void installedVersionRelcacheCallback(Datum arg, Oid relid)
+{
+	if (relid == InvalidOid || relid == currentVariablesTableOid)
+	{
+		currentVariablesTableOid = InvalidOid;
+	}
+}
+
 /*
  * Finds the type length in the type cache. -1 for varlena
  *
@@ -180,16 +579,21 @@ bool checkTypeType(Oid typeOid)
  * Returns a Datum in the expected type or null if no (assignment) implicit cast can be found.
  *
  * BEWARE! the output is malloced instead of palloced. Thus it can be stored directly as session variable.
+ * Unless inlineBuffer is filled and the output fits in inlineContentSize(internalTypeLength) bytes. Then the
+ * output is copied into inlineBuffer.
+ * Varlena output of at least session_variable.compression_threshold bytes is compressed if that saves space.
+ * Use getContent() to read it.
  *
  * @param Oid inputType: The data type of the input data as obtained from the function invocation
  * @param Oid expectedType: The data type that is used for internal storage of the session variable
  * @param int typeLength: -1 for varlena or the number of bytes for scalars
  * @param Datum input: The (detoasted) input
+ * @param char* inlineBuffer: inlineContent() of the variable that is to hold the output, or NULL
  * @param bool* castFailed: will be set to false if the coercion completed correctly of true if it failed
  * @return Datum
  */
 Datum coerceInput(Oid inputType, Oid internalType, int internalTypeLength,
-		Datum input, bool* castFailed)
+		Datum input, char* inlineBuffer, bool* castFailed)
 {
 	CoercionPathType coercionPathType;
 	Oid coercionFunctionOid;
@@ -198,6 +602,7 @@ Datum coerceInput(Oid inputType, Oid internalType, int internalTypeLength,
 	Oid inputFunctionParam;
 	Datum coercedInput;
 	Datum mallocedResult;
+	Datum compressedInput = (Datum) NULL;
 	char* stringValue;
 	bool typeIsVarlena;
 
@@ -216,12 +621,15 @@ Datum coerceInput(Oid inputType, Oid internalType, int internalTypeLength,
 	switch (coercionPathType)
 	{
 	case COERCION_PATH_RELABELTYPE:
+		statistics.relabelCoercions++;
 		coercedInput = input;
 		break;
 	case COERCION_PATH_FUNC:
+		statistics.funcCoercions++;
 		coercedInput = OidFunctionCall1(coercionFunctionOid, input);
 		break;
 	case COERCION_PATH_COERCEVIAIO:
+		statistics.ioCoercions++;
 		getTypeOutputInfo(inputType, &outputFunctionOid, &typeIsVarlena);
 		stringValue = OidOutputFunctionCall(outputFunctionOid, input);
 		getTypeInputInfo(internalType, &inputFunctionOid, &inputFunctionParam);
@@ -235,18 +643,50 @@ Datum coerceInput(Oid inputType, Oid internalType, int internalTypeLength,
 		break;
 	}
 
-	if (internalTypeLength < 0)
+	if (internalTypeLength < 0 && compressionThreshold >= 0
+			&& VARSIZE(coercedInput) >= compressionThreshold)
+	{
+		compressedInput = compressValue(coercedInput);
+	}
+
+	if (compressedInput != (Datum) NULL)
+	{
+		mallocedResult = (Datum) malloc(VARSIZE(compressedInput));
+		memcpy((void*) mallocedResult, (void*) compressedInput,
+				VARSIZE(compressedInput));
+		pfree((void*) compressedInput);
+	}
+	else if (internalTypeLength < 0)
 	{
-		mallocedResult = (Datum) malloc(VARSIZE(coercedInput));
-		SET_VARSIZE(mallocedResult, VARSIZE(coercedInput));
-		memcpy(VARDATA(mallocedResult), VARDATA(coercedInput),
-		VARSIZE(coercedInput) - VARHDRSZ);
+		if (inlineBuffer != NULL && VARSIZE(coercedInput) <= INLINE_CONTENT_SIZE)
+		{
+			/*
+			 * memmove() because the input may be the current inline content
+			 */
+			memmove(inlineBuffer, (void*) coercedInput, VARSIZE(coercedInput));
+			mallocedResult = PointerGetDatum(inlineBuffer);
+		}
+		else
+		{
+			mallocedResult = (Datum) malloc(VARSIZE(coercedInput));
+			SET_VARSIZE(mallocedResult, VARSIZE(coercedInput));
+			memcpy(VARDATA(mallocedResult), VARDATA(coercedInput),
+			VARSIZE(coercedInput) - VARHDRSZ);
+		}
 	}
 	else if (internalTypeLength > SIZEOF_DATUM)
 	{
-		mallocedResult = (Datum) malloc(internalTypeLength);
-		memcpy((void*) mallocedResult, (void*) coercedInput,
-				internalTypeLength);
+		if (inlineBuffer != NULL && internalTypeLength <= INLINE_CONTENT_SIZE)
+		{
+			memmove(inlineBuffer, (void*) coercedInput, internalTypeLength);
+			mallocedResult = PointerGetDatum(inlineBuffer);
+		}
+		else
+		{
+			mallocedResult = (Datum) malloc(internalTypeLength);
+			memcpy((void*) mallocedResult, (void*) coercedInput,
+					internalTypeLength);
+		}
 	}
 	else
 	{
@@ -258,6 +698,115 @@ Datum coerceInput(Oid inputType, Oid internalType, int internalTypeLength,
 	return mallocedResult;
 }
 
+/*
+ * Compresses a varlena value with the compression method of session_variable.compression
+ *
+ * @param Datum value - An uncompressed varlena value with a 4 byte header
+ * @return Datum - The palloced compressed value or NULL if compression does not save enough space
+ */
+Datum compressValue(Datum value)
+{
+#if PG_VERSION_NUM >= 140000
+	return toast_compress_datum(value,
+			compressionMethod == VALUE_COMPRESSION_LZ4 ?
+					TOAST_LZ4_COMPRESSION : TOAST_PGLZ_COMPRESSION);
+#else
+	return toast_compress_datum(value);
+#endif
+}
+
+/*
+ * Returns the content of a variable that is not null, decompressed if it has been compressed by
+ * coerceInput(). The last DECOMPRESSION_CACHE_SIZE decompressed values are kept, so a large variable
+ * that is read repeatedly is decompressed only once. The content of a shared constant is copied out of
+ * shared memory.
+ *
+ * @param SessionVariable* variable - The variable to read
+ * @return Datum - The content. BEWARE! Only valid until the next getContent() or change of the variable
+ */
+Datum getContent(SessionVariable* variable)
+{
+	DecompressedValue* entry;
+	MemoryContext oldContext;
+	int i;
+
+	if (variable->isShared)
+	{
+		return readSharedConstant(variable);
+	}
+
+	if (variable->typeLength >= 0
+			|| !VARATT_IS_COMPRESSED(DatumGetPointer(variable->content)))
+	{
+		return variable->content;
+	}
+
+	for (i = 0; i < DECOMPRESSION_CACHE_SIZE; i++)
+	{
+		if (decompressedValues[i].variable == variable)
+		{
+			return PointerGetDatum(decompressedValues[i].value);
+		}
+	}
+
+	if (decompressionContext == NULL)
+	{
+		decompressionContext = AllocSetContextCreate(TopMemoryContext,
+				"session_variable decompressed values", ALLOCSET_DEFAULT_SIZES);
+	}
+
+	entry = &decompressedValues[nextDecompressedValue];
+	nextDecompressedValue = (nextDecompressedValue + 1) % DECOMPRESSION_CACHE_SIZE;
+	if (entry->value != NULL)
+	{
+		pfree(entry->value);
+	}
+	entry->variable = NULL;
+	entry->value = NULL;
+
+	oldContext = MemoryContextSwitchTo(decompressionContext);
+	entry->value = PG_DETOAST_DATUM(variable->content);
+	MemoryContextSwitchTo(oldContext);
+	entry->variable = variable;
+
+	return PointerGetDatum(entry->value);
+}
+
+/*
+ * Drops the decompressed copy of the content of a variable (if any) because the content is about to change
+ *
+ * @param SessionVariable* variable - The variable whose content changes
+ */
+void forgetDecompressedValue(SessionVariable* variable)
+{
+	int i;
+
+	for (i = 0; i < DECOMPRESSION_CACHE_SIZE; i++)
+	{
+		if (decompressedValues[i].variable == variable)
+		{
+			pfree(decompressedValues[i].value);
+			decompressedValues[i].variable = NULL;
+			decompressedValues[i].value = NULL;
+		}
+	}
+}
+
+/*
+ * Defines the GUCs of the compression of large values. Invoked from _PG_init().
+ */
+void defineCompressionSettings(void)
+{
+	DefineCustomIntVariable("session_variable.compression_threshold",
+			"Values of at least this size are kept compressed in memory, -1 disables compression.",
+			NULL, &compressionThreshold, -1, -1, MaxAllocSize, PGC_USERSET,
+			GUC_UNIT_BYTE, NULL, NULL, NULL);
+	DefineCustomEnumVariable("session_variable.compression",
+			"Compression method for values of at least session_variable.compression_threshold.",
+			NULL, &compressionMethod, VALUE_COMPRESSION_PGLZ,
+			compressionMethodOptions, PGC_USERSET, 0, NULL, NULL, NULL);
+}
+
 /*
  * Returns a Datum in the expected type or null if no (assignment) implicit cast can be found. The result is palloced if necessary
  *
@@ -266,10 +815,11 @@ Datum coerceInput(Oid inputType, Oid internalType, int internalTypeLength,
  * @param Datum internalData: The content of the variable
  * @param Oid outputType: The type of the expected output
  * @param bool* castFailed: will be set to false if the coercion completed correctly of true if it failed
+ * @param CoercionPathType* usedCoercionPath: will be set to the coercion path that was used
  * @return Datum
  */
 Datum coerceOutput(Oid internalType, int internalTypeLength, Datum internalData,
-		Oid outputType, bool* castFailed)
+		Oid outputType, bool* castFailed, CoercionPathType* usedCoercionPath)
 {
 	CoercionPathType coercionPathType;
 	Oid coercionFunctionOid;
@@ -291,10 +841,12 @@ Datum coerceOutput(Oid internalType, int internalTypeLength, Datum internalData,
 		coercionPathType = find_coercion_pathway(outputType, internalType,
 				COERCION_EXPLICIT, &coercionFunctionOid);
 	}
+	*usedCoercionPath = coercionPathType;
 
 	switch (coercionPathType)
 	{
 	case COERCION_PATH_RELABELTYPE:
+		statistics.relabelCoercions++;
 		if (internalTypeLength < 0)
 		{
 			result = (Datum) palloc(VARSIZE(internalData));
@@ -315,10 +867,12 @@ Datum coerceOutput(Oid internalType, int internalTypeLength, Datum internalData,
 		*castFailed = false;
 		return result;
 	case COERCION_PATH_FUNC:
+		statistics.funcCoercions++;
 		result = OidFunctionCall1(coercionFunctionOid, internalData);
 		*castFailed = false;
 		return result;
 	case COERCION_PATH_COERCEVIAIO:
+		statistics.ioCoercions++;
 		getTypeOutputInfo(internalType, &outputFunctionOid, &typeIsVarlena);
 		stringValue = OidOutputFunctionCall(outputFunctionOid, internalData);
 		getTypeInputInfo(outputType, &inputFunctionOid, &inputFunctionParam);
@@ -377,14 +931,42 @@ void removeVariableRecursively(SessionVariable* v)
 	 * The variable is created with malloc() instead of palloc(), so must be
 	 * freed using free() here instead of pfree().
 	 */
-	if (v->typeLength < 0 || v->typeLength > SIZEOF_DATUM)
+	freeContent(v);
+	if (v->usage != NULL)
 	{
-		free((void*) v->content);
+		free((void*) v->usage);
 	}
-	free((void*) v->name);
 	free((void*) v);
 }
 
+/*
+ * Frees the content of a variable if it is malloced separately or stops
+ * reading it from the shared constants
+ *
+ * @param SessionVariable* variable - The variable whose content is no longer needed
+ */
+void freeContent(SessionVariable* variable)
+{
+	if (variable->isShared)
+	{
+		/*
+		 * The session only stops reading the shared value
+		 */
+		variable->isShared = false;
+		return;
+	}
+	if (variable->typeLength < 0)
+	{
+		forgetDecompressedValue(variable);
+	}
+	if (!variable->isNull
+			&& (variable->typeLength < 0 || variable->typeLength > SIZEOF_DATUM)
+			&& DatumGetPointer(variable->content) != inlineContent(variable))
+	{
+		free((void*) variable->content);
+	}
+}
+
 /*
  * Creates the variable
  *
@@ -393,16 +975,21 @@ void removeVariableRecursively(SessionVariable* v)
  * @param Oid valueType the type of the content
  * @param int typeLength  The length of the type, -1 for varlena
  * @param Datum value or null if none. BEWARE! The content of value is supposed to be malloced instead of palloced!
+ *        If it fits inline, it is copied into the variable and freed.
  */
 SessionVariable* createVariable(text* variableName, bool isConst, Oid valueType,
 		int typeLength, bool isNull, Datum value)
 {
+	int nameLength = VARSIZE(variableName) - VARHDRSZ;
+	int valueLength;
+
 	/*
 	 * The variable is to be stored as session variable (read: static variable).
 	 * So we do not use palloc() here, but malloc() instead.
 	 */
 	SessionVariable* result = (SessionVariable*) malloc(
-			sizeof(SessionVariable));
+			MAXALIGN(offsetof(SessionVariable, name) + nameLength + 1)
+					+ inlineContentSize(typeLength));
 
 	elog(
 			DEBUG3,
@@ -413,31 +1000,50 @@ SessionVariable* createVariable(text* variableName, bool isConst, Oid valueType,
 	result->prior = NULL;
 	result->next = NULL;
 
-	result->name = (char*) malloc(VARSIZE(variableName) - VARHDRSZ + 1);
-	memcpy(result->name, VARDATA(variableName),
-	VARSIZE(variableName) - VARHDRSZ);
-	result->name[VARSIZE(variableName) - VARHDRSZ] = '\0';
+	memcpy(result->name, VARDATA(variableName), nameLength);
+	result->name[nameLength] = '\0';
+	result->nameLength = nameLength;
 	result->isConstant = isConst;
 	result->type = valueType;
 	result->typeLength = typeLength;
 	result->isNull = isNull;
+	result->isShared = false;
+	result->isModified = false;
+	result->isTransactionScoped = false;
+	result->modification = ++stateVersion;
 	result->content = value;
+	result->usage = NULL;
+
+	if (!isNull && inlineContentSize(typeLength) > 0)
+	{
+		valueLength = typeLength < 0 ? VARSIZE(value) : typeLength;
+		if (valueLength <= inlineContentSize(typeLength))
+		{
+			memcpy(inlineContent(result), (void*) value, valueLength);
+			free((void*) value);
+			result->content = PointerGetDatum(inlineContent(result));
+		}
+	}
 
 	logVariable(DEBUG2, "createVariable() = ", result);
 	return result;
 }
 
 /*
- * Transforms the list of SessionVariables that has just been loaded from the session_variable.variables table
- * into a binary tree.
- * It expects variables static variable to contain the head of an ordered list of SessionVariables, with each
- * next pointer containing the address of the next SessionVariable or null at the end of the list.
- * The variables static variable will be overwritten with the starting point of the b-tree.
+ * Transforms an ordered list of SessionVariables, as loaded from the session_variable.variables table,
+ * into a balanced binary tree.
+ * Each next pointer in the list must contain the address of the next SessionVariable or null at the end of
+ * the list. The prior pointers are ignored.
+ * Entry i of btreeHelper holds a complete subtree of 2^(i+1) - 1 variables, so lists of up to 2^32 - 1
+ * variables fit.
+ *
+ * @param SessionVariable* list - The head of the ordered list
+ * @return SessionVariable* - The root of the b-tree
  */
-void buildBTree(void)
+SessionVariable* buildBTree(SessionVariable* list)
 {
 	SessionVariable *btreeHelper[32];
-	SessionVariable *lower, *curr, *next;
+	SessionVariable *lower, *curr, *next, *root;
 	int i;
 
 	for (i = 0; i < 32; i++)
@@ -445,7 +1051,7 @@ void buildBTree(void)
 		btreeHelper[i] = NULL;
 	}
 
-	curr = variables;
+	curr = list;
 	while (curr != NULL)
 	{
 		next = curr->next;
@@ -462,104 +1068,299 @@ void buildBTree(void)
 		curr = next;
 	}
 
-	variables = NULL;
+	root = NULL;
 	for (i = 0; i < 32; i++)
 	{
 		if (btreeHelper[i] != NULL)
 		{
-			if (variables == NULL)
+			if (root == NULL)
 			{
-				variables = btreeHelper[i];
+				root = btreeHelper[i];
 			}
 			else
 			{
-				btreeHelper[i]->next = variables;
-				variables = btreeHelper[i];
+				btreeHelper[i]->next = root;
+				root = btreeHelper[i];
 			}
 		}
 	}
+	return root;
 }
 
-Datum deserializeV2(text* varName, Oid dataType, Datum detoastedValue)
+/*
+ * Transforms a (sub)tree into an ordered list of SessionVariables, linked via the next pointers, that can be
+ * fed to buildBTree(). Works by right rotations, so it needs no stack however deep the tree is.
+ *
+ * @param SessionVariable* tree - The root of the (sub)tree, may be NULL
+ * @return SessionVariable* - The head of the list
+ */
+SessionVariable* flattenTree(SessionVariable* tree)
 {
-	HeapTuple typTup;
-	Form_pg_type pgTyp;
-	Oid typInputFunctionOid;
-	Oid typIoParam;
-	char* valueCString;
-	Datum result;
+	SessionVariable* head = NULL;
+	SessionVariable** tail = &head;
+	SessionVariable* lower;
 
-	/*
-	 * Get the type specs
-	 */
-	typTup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(dataType));
-	if (!HeapTupleIsValid(typTup))
+	while (tree != NULL)
 	{
-		elog(ERROR, "cache lookup failed for type %u", dataType);
-		return (Datum) NULL;
+		if (tree->prior != NULL)
+		{
+			lower = tree->prior;
+			tree->prior = lower->next;
+			lower->next = tree;
+			tree = lower;
+		}
+		else
+		{
+			*tail = tree;
+			tail = &tree->next;
+			tree = tree->next;
+		}
 	}
-	pgTyp = (Form_pg_type) GETSTRUCT(typTup);
-	typInputFunctionOid = pgTyp->typinput;
-	typIoParam = getTypeIOParam(typTup);
-	ReleaseSysCache(typTup);
+	return head;
+}
 
-	/*
-	 * Invoke the typinput function
-	 */
-	valueCString = text_to_cstring((text*) detoastedValue);
-	result = OidInputFunctionCall(typInputFunctionOid, valueCString, typIoParam,
-			-1);
-	pfree(valueCString);
-	return result;
+/*
+ * Counts the variables in a (sub)tree
+ *
+ * @param SessionVariable* variable - The root of the (sub)tree, may be NULL
+ * @return int - The number of variables
+ */
+int countNodes(SessionVariable* variable)
+{
+	if (variable == NULL)
+	{
+		return 0;
+	}
+	return 1 + countNodes(variable->prior) + countNodes(variable->next);
 }
 
 /*
- * Walks through the session_variable.variables table to build the SessionVariable b-tree in variables.
- * ----------------------------------------------------------------------------
- * A _PG_INIT function appears not usable for this purpose because access
- * rights on the session_variable.variables table appear to be handled
- * differently when invoked as part of the initialisation from a preload
- * library or when invoked in "normal" code processing. So every function that
- * is externally accessible checks if 'virgin' is still set and if so invokes
- * reload(). This function resets 'virgin'.
- * ----------------------------------------------------------------------------
+ * Keeps the b-tree balanced after the variable with the name variableName has been added to it.
+ * Variables that are created in sorted order, as provisioning scripts tend to do, would otherwise turn the
+ * tree into a list, making lookups linear and the recursive tree walks as deep as the number of variables.
+ * If the new variable lies deeper than log1.5(variableCount), the subtree under the lowest ancestor that has
+ * more than 2/3 of its variables at one side is rebuilt as a balanced tree. Such an ancestor always exists
+ * then. This is the scapegoat tree approach, which costs O(log(n)) per insert amortised.
  *
- * @return int The number or SessionVariables created
+ * @param char* variableName - Name of the variable that has just been added
  */
-int reload()
+void rebalance(char* variableName)
 {
-	char* sql = "select variable_name"
-			", is_constant"
-			", typ.oid"
-			", initial_value"
-			" from session_variable.variables var"
-			" join pg_catalog.pg_namespace nsp"
-			" on var.variable_type_namespace = nsp.nspname"
-			" join pg_catalog.pg_type typ"
-			" on nsp.oid = typ.typnamespace"
-			" and var.variable_type_name = typ.typname"
-			" and typ.typtype <> 'p'"
-			" order by variable_name";
-	text* variableName = NULL;
-	bool isConstValue;
-	Oid valueType;
-	Datum value = (Datum) NULL;
-	Datum mallocedValue;
-	bool isNull;
+	SessionVariable*** path;
+	SessionVariable** link = &variables;
+	SessionVariable* parent;
+	int pathSize = 32;
+	int depth = 0;
+	int maxDepth;
+	int diff;
+	int childSize;
+	int size;
+	int i;
+
+	if (variableCount < 3)
+	{
+		return;
+	}
+	maxDepth = (int) (log((double) variableCount) / log(1.5));
+
+	/*
+	 * Remember the links from the root to the new variable
+	 */
+	path = (SessionVariable***) palloc(pathSize * sizeof(SessionVariable**));
+	while (*link != NULL)
+	{
+		if (depth == pathSize)
+		{
+			pathSize *= 2;
+			path = (SessionVariable***) repalloc(path,
+					pathSize * sizeof(SessionVariable**));
+		}
+		path[depth] = link;
+		diff = strcmp(variableName, (*link)->name);
+		if (diff == 0)
+		{
+			break;
+		}
+		link = diff < 0 ? &(*link)->prior : &(*link)->next;
+		depth++;
+	}
+
+	if (depth > maxDepth)
+	{
+		childSize = 1;
+		for (i = depth - 1; i >= 0; i--)
+		{
+			parent = *path[i];
+			size = childSize + 1
+					+ countNodes(path[i + 1] == &parent->prior ? parent->next : parent->prior);
+			if (3 * childSize > 2 * size)
+			{
+				elog(DEBUG2, "rebalance('%s'): rebuilding %d variables under \"%s\"",
+						variableName, size, parent->name);
+				*path[i] = buildBTree(flattenTree(parent));
+				break;
+			}
+			childSize = size;
+		}
+	}
+
+	pfree(path);
+}
+
+/*
+ * Walks the b-tree to count the variables, the memory held by their names and
+ * values and the depth of the tree.
+ *
+ * @param SessionVariable* variable - The (sub)tree to walk, may be NULL
+ * @param int depth - The depth of variable in the tree, 1 for the root
+ * @param int* nrVariables - Incremented for each variable
+ * @param int* treeDepth - Raised to the depth of the deepest variable
+ * @param int64* nameBytes - Incremented with the size of each name
+ * @param int64* valueBytes - Incremented with the size of each malloced value, shared constants excluded
+ */
+void collectTreeStatistics(SessionVariable* variable, int depth,
+		int* nrVariables, int* treeDepth, int64* nameBytes, int64* valueBytes)
+{
+	if (variable == NULL)
+	{
+		return;
+	}
+
+	(*nrVariables)++;
+	if (depth > *treeDepth)
+	{
+		*treeDepth = depth;
+	}
+	*nameBytes += variable->nameLength + 1;
+	if (!variable->isNull && !variable->isShared)
+	{
+		if (variable->typeLength < 0)
+		{
+			*valueBytes += VARSIZE(variable->content);
+		}
+		else if (variable->typeLength > SIZEOF_DATUM)
+		{
+			*valueBytes += variable->typeLength;
+		}
+	}
+
+	collectTreeStatistics(variable->prior, depth + 1, nrVariables, treeDepth,
+			nameBytes, valueBytes);
+	collectTreeStatistics(variable->next, depth + 1, nrVariables, treeDepth,
+			nameBytes, valueBytes);
+}
+
+Datum deserializeV2(text* varName, Oid dataType, Datum detoastedValue)
+{
+	HeapTuple typTup;
+	Form_pg_type pgTyp;
+	Oid typInputFunctionOid;
+	Oid typIoParam;
+	char* valueCString;
+	Datum result;
+
+	/*
+	 * Get the type specs
+	 */
+	typTup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(dataType));
+	if (!HeapTupleIsValid(typTup))
+	{
+		elog(ERROR, "cache lookup failed for type %u", dataType);
+		return (Datum) NULL;
+	}
+	pgTyp = (Form_pg_type) GETSTRUCT(typTup);
+	typInputFunctionOid = pgTyp->typinput;
+	typIoParam = getTypeIOParam(typTup);
+	ReleaseSysCache(typTup);
+
+	/*
+	 * Invoke the typinput function
+	 */
+	valueCString = text_to_cstring((text*) detoastedValue);
+	result = OidInputFunctionCall(typInputFunctionOid, valueCString, typIoParam,
+			-1);
+	pfree(valueCString);
+	return result;
+}
+
+/*
+ * Reads the variables that satisfy the condition from the
+ * session_variable.variables table. The initial value is taken from the most
+ * specific row in session_variable.variable_overrides that applies to the
+ * session, if any: one for the session user and the application_name over one
+ * for the session user over one for the application_name. Before the
+ * extension is updated to this version there are no overrides and all
+ * variables are session scoped. The deferred writes of the transaction are
+ * not in the table yet, see applyPendingWrites().
+ *
+ * @param char* condition - Where clause of the query, may refer to $1 and $2
+ * @param int nrArgs - The number of text arguments of the condition
+ * @param Datum* args - The text arguments of the condition
+ * @param int* nrVariables - Is incremented by the number of variables read
+ * @return SessionVariable* - The variables read, ordered by name and linked by
+ *         their next pointers
+ */
+SessionVariable* loadVariables(char* condition, int nrArgs, Datum* args,
+		int* nrVariables)
+{
+	char* overrides = "(select distinct on (variable_name)"
+			" variable_name"
+			", initial_value"
+			" from session_variable.variable_overrides"
+			" where coalesce(role_name = session_user, true)"
+			" and coalesce(application_name"
+			" = pg_catalog.current_setting('application_name'), true)"
+			" order by variable_name"
+			", role_name is null"
+			", application_name is null"
+			")";
+	char* noOverrides = "(select null::text as variable_name"
+			", null::text as initial_value"
+			" where false"
+			")";
+	char* sql;
+	bool isCurrent = isInstalledVersionCurrent();
+	Oid argTypes[2] = {TEXTOID, TEXTOID};
+	text* variableName = NULL;
+	bool isConstValue;
+	Oid valueType;
+	Datum value = (Datum) NULL;
+	SessionVariable* variable;
+	SessionVariable* list = NULL;
+	SessionVariable** nextVar = &list;
+	bool isNull;
 	Portal cursor = NULL;
-	int nrVariables = 0;
-	SessionVariable** nextVar = &variables;
 	int typeLength;
 	bool castFailed;
 	Datum rawValue;
 	Datum detoastedValue;
+	Timestamp lastUpdated;
+	bool isOverridden;
+	bool isTransactionScoped;
 
-	/*
-	 * Clear the old content (if any).
-	 */
-	removeVariableRecursively(variables);
-	variables = NULL;
-	virgin = false;
+	sql = psprintf("select var.variable_name"
+			", var.is_constant"
+			", typ.oid"
+			", case when ovr.variable_name is null"
+			" then var.initial_value"
+			" else ovr.initial_value"
+			" end"
+			", var.last_updated_timestamp"
+			", ovr.variable_name is not null"
+			", %s"
+			" from session_variable.variables var"
+			" join pg_catalog.pg_namespace nsp"
+			" on var.variable_type_namespace = nsp.nspname"
+			" join pg_catalog.pg_type typ"
+			" on nsp.oid = typ.typnamespace"
+			" and var.variable_type_name = typ.typname"
+			" and typ.typtype <> 'p'"
+			" left join %s ovr"
+			" on ovr.variable_name = var.variable_name"
+			" where %s"
+			" order by var.variable_name",
+			isCurrent ? "var.variable_scope = 'transaction'" : "false",
+			isCurrent ? overrides : noOverrides, condition);
 
 	elog(DEBUG3, "execute query: %s", sql);
 
@@ -568,8 +1369,8 @@ int reload()
 	/*
 	 * Walk through the session_variable.variables table
 	 */
-	cursor = SPI_cursor_open_with_args(NULL, sql, 0, NULL, NULL, NULL, true,
-	CURSOR_OPT_BINARY | CURSOR_OPT_NO_SCROLL);
+	cursor = SPI_cursor_open_with_args(NULL, sql, nrArgs, argTypes, args, NULL,
+			true, CURSOR_OPT_BINARY | CURSOR_OPT_NO_SCROLL);
 	SPI_cursor_fetch(cursor, true, 1);
 	while (!cursor->atEnd)
 	{
@@ -582,1332 +1383,5787 @@ int reload()
 		valueType = SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc,
 				3, &isNull);
 		typeLength = getTypeLength(valueType);
+		lastUpdated = DatumGetTimestamp(
+				SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 5,
+						&isNull));
+		isOverridden = DatumGetBool(
+				SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 6,
+						&isNull));
+		isTransactionScoped = DatumGetBool(
+				SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 7,
+						&isNull));
 		rawValue = SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc,
 				4, &isNull);
-		if (isNull)
-		{
-			mallocedValue = (Datum) NULL;
-		}
-		else
+
+		/*
+		 * Create the new variable and link it to its predecessor.
+		 */
+		variable = createVariable(variableName, isConstValue, valueType,
+				typeLength, true, (Datum) NULL);
+		variable->isTransactionScoped = isTransactionScoped;
+		*nextVar = variable;
+		nextVar = &variable->next;
+
+		/*
+		 * A constant that another session has loaded already is read from
+		 * the shared constants, unless this session overrides its value
+		 */
+		if (!isNull
+				&& !(isConstValue && !isOverridden
+						&& useSharedConstant(variable, lastUpdated)))
 		{
 			detoastedValue = (Datum) PG_DETOAST_DATUM(rawValue);
 
 			value = deserialize(variableName, valueType, detoastedValue);
 
 			/*
-			 * we want the value to be malloced instead of palloced.
+			 * we want the value to be malloced instead of palloced, or inline.
 			 */
-			mallocedValue = coerceInput(valueType, valueType, typeLength, value,
-					&castFailed);
+			variable->content = coerceInput(valueType, valueType, typeLength,
+					value, inlineContent(variable), &castFailed);
+			variable->isNull = false;
 
-			isNull = false;
+			if (!isOverridden)
+			{
+				shareContent(variable, lastUpdated);
+			}
 		}
 
-		/*
-		 * Create the new value and link it to its predecessor.
-		 */
-		*nextVar = createVariable(variableName, isConstValue, valueType,
-				typeLength, isNull, mallocedValue);
-		nextVar = &(*nextVar)->next;
-
-		nrVariables++;
+		(*nrVariables)++;
 		SPI_cursor_fetch(cursor, true, 1);
 	}
 	SPI_cursor_close(cursor);
 	SPI_finish();
+	pfree(sql);
 
-	buildBTree();
-
-	invokeInitialisationFunction();
-
-	elog(DEBUG3, "reload() = %d", nrVariables);
-	return nrVariables;
+	return list;
 }
 
 /*
- * Checks if a no-argument function called session_variable.initialze_variables()
- * exists and, if so, invokes it.
+ * Walks through the session_variable.variables table to build the SessionVariable b-tree in variables.
+ * ----------------------------------------------------------------------------
+ * A _PG_INIT function appears not usable for this purpose because access
+ * rights on the session_variable.variables table appear to be handled
+ * differently when invoked as part of the initialisation from a preload
+ * library or when invoked in "normal" code processing. So every function that
+ * is externally accessible checks if 'virgin' is still set and if so invokes
+ * reload(). This function resets 'virgin'.
+ * ----------------------------------------------------------------------------
+ * If session_variable.lazy_load_groups is on, only the variables without a
+ * group, see loadGroup(), and the groups that were loaded already are read.
+ * Otherwise the variables are taken from the catalog that the preload worker
+ * has loaded, if it is up to date, see restorePreloadedCatalog().
+ *
+ * @return int The number or SessionVariables created
  */
-void invokeInitialisationFunction()
+int reload()
 {
-	Oid namespaceOid;
-	char* dbName;
+	SessionVariable* list;
+	LoadedGroup* group;
+	Datum args[2];
+	int nrVariables = 0;
+	instr_time startTime;
+	instr_time duration;
+	int64 reloadTime;
 
-	dbName = get_database_name(MyDatabaseId);
-	namespaceOid = get_namespace_oid("session_variable", true);
-	if (OidIsValid(namespaceOid))
+	if (!OidIsValid(MyDatabaseId))
 	{
-		/*
-		 * Check if a no-argument function called "variable_initialisation" exists in namespace
-		 * "session_variable"
-		 */
-		oidvector* emptyArgVector = buildoidvector(NULL, 0);
-		if (SearchSysCacheExists3(PROCNAMEARGSNSP,
-				CStringGetDatum("variable_initialisation"),
-				PointerGetDatum(buildoidvector(NULL, 0)),
-				ObjectIdGetDatum(namespaceOid)))
-		{
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE), (errmsg("session_variable can only be used in a process that is connected to a database"))));
+	}
 
-			SPI_connect();
+	INSTR_TIME_SET_CURRENT(startTime);
 
-			elog(
-					DEBUG3,
-					"login_hook will execute select session_variable.variable_initialisation() in database %s",
-					dbName);
-			isExecutingInitialisationFunction = true;
-			SPI_execute("select session_variable.variable_initialisation()",
-			false, 1);
-			isExecutingInitialisationFunction = false;
-			elog(
-					DEBUG3,
-					"login_hook is back from select session_variable.variable_initialisation() in database %s",
-					dbName);
+	if (sharedStatistics != NULL && !statisticsCallbacksRegistered)
+	{
+		before_shmem_exit(statisticsShmemExit, (Datum) 0);
+		RegisterXactCallback(statisticsXactCallback, NULL);
+		statisticsCallbacksRegistered = true;
+	}
 
-			SPI_finish();
+	/*
+	 * Clear the old content (if any).
+	 */
+	flushStatistics();
+	forgetCoercedValues();
+	transactionScopedValues = NULL;
+	removeVariableRecursively(variables);
+	variables = NULL;
+	variableCount = 0;
+	virgin = false;
+	stateVersion++;
+	handleGeneration++;
+
+	/*
+	 * A parallel worker takes over the variables of its leader
+	 */
+	if (IsParallelWorker() && parallelState != NULL && *parallelState != '\0')
+	{
+		return restoreParallelState();
+	}
+
+	/*
+	 * The deferred writes of the transaction are not left out of a full load
+	 */
+	flushPendingWrites();
+
+	if (lazyLoadGroups)
+	{
+		list = loadVariables("strpos(var.variable_name, '.') = 0", 0, NULL,
+				&nrVariables);
+		for (group = loadedGroups; group != NULL; group = group->next)
+		{
+			groupRange(group->prefix, args);
+			list = mergeVariableLists(list,
+					loadVariables(
+							"var.variable_name >= $1 and var.variable_name < $2",
+							2, args, &nrVariables));
+		}
+	}
+	else
+	{
+		forgetLoadedGroups();
+		if (restorePreloadedCatalog(&list, &nrVariables))
+		{
+			statistics.preloadedReloads++;
 		}
 		else
 		{
-			elog(
-					DEBUG1,
-					"Function session_variable.variable_initialisation() is not invoked because it does not exist in database %s",
-					dbName);
+			list = loadVariables("true", 0, NULL, &nrVariables);
 		}
+	}
 
-		pfree(emptyArgVector);
+	variables = buildBTree(list);
+	variableCount = nrVariables;
+
+	invokeInitialisationFunction();
+	forgetAppliedSettings();
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, startTime);
+	reloadTime = (int64) INSTR_TIME_GET_MICROSEC(duration);
+	statistics.reloadCalls++;
+	statistics.reloadTotalTime += reloadTime;
+	if (reloadTime > statistics.reloadMaxTime)
+	{
+		statistics.reloadMaxTime = reloadTime;
 	}
+
+	elog(DEBUG3, "reload() = %d", nrVariables);
+	return nrVariables;
 }
 
 /*
- * function session_variable.is_executing_variable_initialisation() returns boolean.
- *
- * This function returns true if the session_variable.variable_initialisation() function is executing
- * under control of the session_variable code.
+ * Defines session_variable.lazy_load_groups. Invoked from _PG_init().
  */
-PG_FUNCTION_INFO_V1(is_executing_variable_initialisation);
-PGDLLEXPORT Datum is_executing_variable_initialisation( PG_FUNCTION_ARGS)
+void defineLazyLoading(void)
 {
-	PG_RETURN_BOOL(isExecutingInitialisationFunction);
+	DefineCustomBoolVariable("session_variable.lazy_load_groups",
+			"Loads a group of variables, named <group>.<name>, when one of them is used first.",
+			NULL, &lazyLoadGroups, false, PGC_USERSET, 0, NULL, NULL, NULL);
 }
 
 /*
- * Converts the content of the variable to a text Datum using the type's
- * outfunction.
+ * Fills args with the lower bound (inclusive) and upper bound (exclusive) of
+ * the names in the group, so that the primary key of the
+ * session_variable.variables table can be used to read the group.
  *
- * @param SessionVariable* variable - The variable of which the content is to be
- *                                    serialized
- * @return Datum - The initial value serialized using the type's outfunction
- *                 or null if the variable's content was null
+ * @param char* prefix - The group name including the dot
+ * @param Datum* args - Receives two text datums
  */
-Datum serializeV2(SessionVariable* variable)
+void groupRange(char* prefix, Datum* args)
 {
-	HeapTuple typTup;
-	Form_pg_type typ;
-	Oid typOutputFunctionOid;
-	char* serialized;
-	Datum result;
-
-	if (variable->isNull)
-	{
-		return (Datum) NULL;
-	}
+	char* upperBound = pstrdup(prefix);
 
 	/*
-	 * Get the type specs
+	 * The prefix ends with a dot, so the next character value does not
+	 * overflow
 	 */
-	typTup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(variable->type));
-	if (!HeapTupleIsValid(typTup))
+	upperBound[strlen(upperBound) - 1]++;
+	args[0] = CStringGetTextDatum(prefix);
+	args[1] = CStringGetTextDatum(upperBound);
+}
+
+/*
+ * Forgets which groups are loaded, after all variables have been loaded
+ */
+void forgetLoadedGroups(void)
+{
+	LoadedGroup* group;
+
+	while (loadedGroups != NULL)
 	{
-		elog(ERROR, "cache lookup failed for type %u", variable->type);
-		return (Datum) NULL;
+		group = loadedGroups;
+		loadedGroups = group->next;
+		free((void*) group);
 	}
-	typ = (Form_pg_type) GETSTRUCT(typTup);
-	typOutputFunctionOid = typ->typoutput;
-	ReleaseSysCache(typTup);
+}
 
-	/*
-	 * Serialize the initialValue into a character array
-	 */
-	serialized = OidOutputFunctionCall(typOutputFunctionOid, variable->content);
-	if (!serialized)
+/*
+ * Loads the group of the variable if session_variable.lazy_load_groups is on
+ * and the group has not been loaded yet. The group of a variable is the part
+ * of its name up to and including the first dot. Variables without a dot in
+ * their name are loaded by reload().
+ *
+ * @param char* variableName - Name of the variable that is not in memory
+ * @return bool - true if variables have been added to the b-tree
+ */
+bool loadGroup(char* variableName)
+{
+	char* dot;
+	int prefixLength;
+	LoadedGroup* group;
+	Datum args[2];
+	SessionVariable* list;
+	SessionVariable* newVariables = NULL;
+	SessionVariable** nextVar = &newVariables;
+	SessionVariable* variable;
+	int nrVariables = 0;
+	bool found;
+
+	if (!lazyLoadGroups || virgin)
 	{
-		/*
-		 * something went wrong. Let's hope it is logged
-		 */
-		return (Datum) NULL;
+		return false;
+	}
+	dot = strchr(variableName, '.');
+	if (dot == NULL)
+	{
+		return false;
+	}
+	prefixLength = dot - variableName + 1;
+	for (group = loadedGroups; group != NULL; group = group->next)
+	{
+		if (group->prefixLength == prefixLength
+				&& !memcmp(group->prefix, variableName, prefixLength))
+		{
+			return false;
+		}
 	}
 
 	/*
-	 * Wrap into a bytea
+	 * Registered before reading, so a group without variables is not read
+	 * again at every miss
 	 */
-	result = (Datum) cstring_to_text(serialized);
-	pfree(serialized);
+	group = (LoadedGroup*) malloc(
+			offsetof(LoadedGroup, prefix) + prefixLength + 1);
+	memcpy(group->prefix, variableName, prefixLength);
+	group->prefix[prefixLength] = '\0';
+	group->prefixLength = prefixLength;
+	group->next = loadedGroups;
+	loadedGroups = group;
 
-	return result;
+	elog(DEBUG1, "@>loadGroup(%s)", group->prefix);
+
+	groupRange(group->prefix, args);
+	list = applyPendingWrites(
+			loadVariables("var.variable_name >= $1 and var.variable_name < $2",
+					2, args, &nrVariables), group->prefix, true, &nrVariables);
+
+	/*
+	 * Skip variables that are in memory already, for example because
+	 * session_variable.lazy_load_groups has been switched on after a full
+	 * load or because they have been shipped by the leader of a parallel
+	 * query
+	 */
+	while (list != NULL)
+	{
+		variable = list;
+		list = list->next;
+		variable->next = NULL;
+		searchVariable(variable->name, &variables, &found);
+		if (found)
+		{
+			removeVariableRecursively(variable);
+			nrVariables--;
+		}
+		else
+		{
+			*nextVar = variable;
+			nextVar = &variable->next;
+		}
+	}
+
+	if (newVariables != NULL)
+	{
+		variables = buildBTree(
+				mergeVariableLists(flattenTree(variables), newVariables));
+		variableCount += nrVariables;
+		stateVersion++;
+	}
+
+	elog(DEBUG1, "@<loadGroup(%s) = %d", group->prefix, nrVariables);
+	return newVariables != NULL;
 }
 
 /*
- * Inserts the variable into the session_variable.variables table
- *
- * @param SessionVariable* variable
- * @return bool: true if ok
+ * Defines session_variable.parallel_state, through which the variables of the
+ * leader of a parallel query are shipped to its workers along with the other
+ * GUCs, and installs the executor hook that fills it. Invoked from _PG_init(),
+ * also in parallel workers, which restore the GUCs after loading the library.
+ * The setting is superuser only, so an ordinary user can neither hand a
+ * forged state to the workers nor read the values of all variables from it.
+ * It cannot be PGC_INTERNAL, because those settings are not shipped to
+ * parallel workers.
  */
-bool insertVariable(SessionVariable* variable)
+void defineParallelState(void)
 {
-	char* sql = "insert into session_variable.variables "
-			"( variable_name"
-			", is_constant"
-			", variable_type_namespace"
-			", variable_type_name"
-			", initial_value"
-			") "
-			"select $1"
-			", $2"
-			", nsp.nspname"
-			", typ.typname"
-			", $4 "
-			"from pg_catalog.pg_type typ "
-			"join pg_catalog.pg_namespace nsp on typ.typnamespace = nsp.oid "
-			"where typ.oid = $3";
-	const size_t nrArgs = 4;
-	Oid* oid;
-	Datum* val;
-	char* nulls;
-	bool result;
+	DefineCustomStringVariable("session_variable.parallel_state",
+			"Variables of the leader of a parallel query, for internal use only.",
+			NULL, &parallelState, "", PGC_SUSET,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_DISALLOW_IN_FILE
+					| GUC_SUPERUSER_ONLY, NULL, NULL, NULL);
+
+	previousExecutorStartHook = ExecutorStart_hook;
+	ExecutorStart_hook = parallelStateExecutorStart;
+}
 
-	oid = (Oid*)palloc(sizeof(Oid) * nrArgs);
-	val = (Datum*)palloc(sizeof(Datum) * nrArgs);
-	nulls = (char*)palloc(sizeof(char) * nrArgs);
+/*
+ * ExecutorStart_hook: ships the variables to the workers if the query may run
+ * in parallel
+ */
+void parallelStateExecutorStart(QueryDesc* queryDesc, int eflags)
+{
+	if (queryDesc->plannedstmt->parallelModeNeeded && !IsInParallelMode())
+	{
+		shipParallelState();
+	}
 
-	oid[0] = TEXTOID;
-	val[0] = (Datum) cstring_to_text(variable->name);
-	nulls[0] = ' ';
-	oid[1] = BOOLOID;
-	val[1] = BoolGetDatum(variable->isConstant);
-	nulls[1] = ' ';
-	oid[2] = REGTYPEOID;
-	val[2] = ObjectIdGetDatum(variable->type);
-	nulls[2] = ' ';
-	oid[3] = initialValueTypeOid;
-	if (variable->isNull)
+	if (previousExecutorStartHook)
 	{
-		val[3] = PointerGetDatum(NULL);
-		nulls[3] = 'n';
+		previousExecutorStartHook(queryDesc, eflags);
 	}
 	else
 	{
-		val[3] = serialize(variable);
-		nulls[3] = ' ';
+		standard_ExecutorStart(queryDesc, eflags);
 	}
-
-	SPI_connect();
-	result = SPI_execute_with_args(sql, nrArgs, oid, val, nulls, false, 1);
-	SPI_finish();
-
-	pfree(oid);
-	pfree(val);
-	pfree(nulls);
-
-	return result;
 }
 
 /*
- * Updates the variable's initial value in the session_variable.variables table
+ * Appends the variable and its subordinates in name order to buffer, see
+ * ParallelStateVariable
  *
- * @param SessionVariable* variable
+ * @param SessionVariable* variable - The (sub)tree to serialize, may be NULL
+ * @param StringInfo buffer - Receives the serialized variables
  */
-void updateVariable(SessionVariable* variable)
+void serializeVariables(SessionVariable* variable, StringInfo buffer)
 {
-	char* sql = "update session_variable.variables"
-			" set initial_value = $1"
-			" where variable_name = $2";
-	static const size_t nrArgs = 2;
-	Oid* oid;
-	Datum* val;
-	char* nulls;
+	ParallelStateVariable header;
+	Datum content = (Datum) NULL;
 
-	oid = (Oid*)palloc(sizeof(Oid) * nrArgs);
-	val = (Datum*)palloc(sizeof(Datum) * nrArgs);
-	nulls = (char*)palloc(sizeof(char) * nrArgs);
+	if (variable == NULL)
+	{
+		return;
+	}
 
-	oid[0] = initialValueTypeOid;
-	if (variable->isNull)
+	serializeVariables(variable->prior, buffer);
+
+	memset(&header, 0, sizeof(header));
+	header.type = variable->type;
+	header.nameLength = variable->nameLength;
+	header.isConstant = variable->isConstant;
+	header.isNull = variable->isNull;
+	header.isTransactionScoped = variable->isTransactionScoped;
+	if (!variable->isNull)
 	{
-		val[0] = PointerGetDatum(NULL);
-		nulls[0] = 'n';
+		content = getContent(variable);
+		if (variable->typeLength >= 0 && variable->typeLength <= SIZEOF_DATUM)
+		{
+			header.content = content;
+		}
+		else
+		{
+			header.contentSize = datumGetSize(content, false,
+					variable->typeLength);
+		}
 	}
-	else
+	appendBinaryStringInfo(buffer, (char*) &header, sizeof(header));
+	appendBinaryStringInfo(buffer, variable->name, variable->nameLength);
+	if (header.contentSize > 0)
 	{
-		val[0] = serialize(variable);
-		nulls[0] = ' ';
+		appendBinaryStringInfo(buffer, DatumGetPointer(content),
+				header.contentSize);
 	}
 
-	oid[1] = TEXTOID;
-	val[1] = (Datum) cstring_to_text(variable->name);
-	nulls[1] = ' ';
+	serializeVariables(variable->next, buffer);
+}
 
-	SPI_connect();
-	SPI_execute_with_args(sql, nrArgs, oid, val, nulls, false, 1);
-	SPI_finish();
+/*
+ * Stores the variables of the session in session_variable.parallel_state,
+ * unless they have not changed since they were stored last. Variables that
+ * have not been loaded yet are loaded first, so the workers need not each
+ * read the catalog. The setting is emptied if the extension is not installed
+ * in the database.
+ */
+void shipParallelState(void)
+{
+	StringInfoData buffer;
+	char* hex;
+	uint64 sharedConstantsVersion = 0;
 
-	pfree(oid);
-	pfree(val);
-	pfree(nulls);
+	if (virgin && !loadVariablesAsOwner())
+	{
+		if (parallelState != NULL && *parallelState != '\0')
+		{
+			set_config_option("session_variable.parallel_state", "",
+					PGC_SUSET, PGC_S_SESSION, GUC_ACTION_SET, true, 0, false);
+		}
+		shippedParallelState = NULL;
+		return;
+	}
+
+	if (sharedConstantsControl != NULL)
+	{
+		sharedConstantsVersion = sharedConstantsControl->version;
+	}
+	if (parallelState == shippedParallelState
+			&& stateVersion == shippedStateVersion
+			&& sharedConstantsVersion == shippedSharedConstantsVersion)
+	{
+		return;
+	}
+
+	initStringInfo(&buffer);
+	appendBinaryStringInfo(&buffer, (char*) &variableCount,
+			sizeof(variableCount));
+	serializeVariables(variables, &buffer);
+
+	hex = palloc(buffer.len * 2 + 1);
+	hex[hex_encode(buffer.data, buffer.len, hex)] = '\0';
+	set_config_option("session_variable.parallel_state", hex, PGC_SUSET,
+			PGC_S_SESSION, GUC_ACTION_SET, true, 0, false);
+	pfree(hex);
+	pfree(buffer.data);
+
+	shippedParallelState = parallelState;
+	shippedStateVersion = stateVersion;
+	shippedSharedConstantsVersion = sharedConstantsVersion;
 }
 
 /*
- * Deletes the directory reference from the file_system.directory_reference table
+ * Loads the variables as the owner of the catalog, like the security definer
+ * functions of the extension do, for a query that does not invoke them
  *
- * @param text* directoryRefereceName
- * @return int the result of the SPI_execute_with_args() invocation
+ * @return bool - false if the extension is not installed in the database
  */
-void deleteVariable(text* variableName)
+bool loadVariablesAsOwner(void)
 {
-	char* sql =
-			"delete from session_variable.variables where variable_name = $1";
-	const size_t nrArgs = 1;
-	Oid* oid;
-	Datum* val;
+	Oid namespaceOid = get_namespace_oid("session_variable", true);
+	Oid tableOid = InvalidOid;
+	HeapTuple tuple;
+	Oid ownerOid;
+	Oid savedUserId;
+	int savedSecurityContext;
 
-	oid = (Oid*)palloc(sizeof(Oid) * nrArgs);
-	val = (Datum*)palloc(sizeof(Datum) * nrArgs);
+	if (OidIsValid(namespaceOid))
+	{
+		tableOid = get_relname_relid("variables", namespaceOid);
+	}
+	if (!OidIsValid(tableOid))
+	{
+		return false;
+	}
+	tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(tableOid));
+	if (!HeapTupleIsValid(tuple))
+	{
+		return false;
+	}
+	ownerOid = ((Form_pg_class) GETSTRUCT(tuple))->relowner;
+	ReleaseSysCache(tuple);
 
-	oid[0] = TEXTOID;
-	val[0] = (Datum) variableName;
+	/*
+	 * An error resets the user at the abort of the (sub)transaction
+	 */
+	GetUserIdAndSecContext(&savedUserId, &savedSecurityContext);
+	SetUserIdAndSecContext(ownerOid,
+			savedSecurityContext | SECURITY_LOCAL_USERID_CHANGE);
+	reload();
+	SetUserIdAndSecContext(savedUserId, savedSecurityContext);
+	return true;
+}
 
-	SPI_connect();
-	SPI_execute_with_args(sql, nrArgs, oid, val, NULL, false, 1);
-	SPI_finish();
+/*
+ * Builds the variables of a parallel worker from session_variable.parallel_state
+ * as filled by the leader in shipParallelState()
+ *
+ * @return int - The number of variables
+ */
+int restoreParallelState(void)
+{
+	int stateLength = strlen(parallelState) / 2;
+	char* state = palloc(stateLength);
+	int nrVariables;
 
-	pfree(oid);
-	pfree(val);
+	hex_decode(parallelState, stateLength * 2, state);
+	variables = buildBTree(restoreVariables(state, stateLength, &nrVariables));
+	variableCount = nrVariables;
+	pfree(state);
+
+	elog(DEBUG3, "restoreParallelState() = %d", nrVariables);
+	return nrVariables;
 }
 
 /*
- * Searches the binary tree for the variableName
- *
- * If a matching name is found, found wil be set to true and the var with the corresponding name will
- * be returned.
- *
- * If no variables exist, NULL will be returned.
+ * Checks that state holds the variables that serializeVariables() writes,
+ * preceded by their number, so restoreVariables() neither reads beyond state
+ * nor takes over content that does not fit the type. Raises an error
+ * otherwise.
  *
- * Else found will be set to false and the variable under which the new variable is to be positioned
- * will be returned. So if the variableName is less than the name in the returned variable, then the
- * prior pointer of the returned variable will be NULL. Otherwise the next pointer of the returned
- * variable will be NULL.
- *
- * @param char* variableName: Name to be found
- * @param SessionVariable** lvl: The variables static variable or a parent level under which to search
- * @param bool* found: Will be set true if the variableName is found or false if not
- * @return SessionVariable*: If found == true, the var that we were looking for.
- *              else the var under which the new variable should be stored of null if no variables exist yet.
+ * @param char* state - The serialized variables
+ * @param Size stateLength - The length of state in bytes
  */
-SessionVariable* searchVariable(char* variableName, SessionVariable** lvl,
-		bool* found)
+void checkSerializedVariables(char* state, Size stateLength)
 {
-	int diff;
-
-	elog(DEBUG2, "searchVariable('%s')", variableName);
+	char* position = state;
+	char* end = state + stateLength;
+	ParallelStateVariable header;
+	int nrVariables = -1;
+	int typeLength;
+	bool isValid;
+	int i;
 
-	if (*lvl == NULL)
+	isValid = stateLength >= sizeof(nrVariables);
+	if (isValid)
 	{
-		*found = false;
-		elog(DEBUG2, "searchVariable(%s) = not found", variableName);
-		return NULL;
+		memcpy(&nrVariables, position, sizeof(nrVariables));
+		position += sizeof(nrVariables);
+		isValid = nrVariables >= 0;
 	}
 
-	diff = strcmp(variableName, (*lvl)->name);
-
-	if (diff < 0)
+	for (i = 0; isValid && i < nrVariables; i++)
 	{
-		if ((*lvl)->prior == NULL)
+		if ((Size) (end - position) < sizeof(header))
 		{
-			*found = false;
-			return *lvl;
+			isValid = false;
+			break;
 		}
-		logVariable(DEBUG2, "not found (yet) search(prior):", (*lvl));
-		return searchVariable(variableName, &(*lvl)->prior, found);
-	}
+		memcpy(&header, position, sizeof(header));
+		position += sizeof(header);
 
-	if (diff > 0)
-	{
-		if ((*lvl)->next == NULL)
+		if (header.nameLength <= 0 || header.nameLength > end - position
+				|| !SearchSysCacheExists1(TYPEOID,
+						ObjectIdGetDatum(header.type)))
+		{
+			isValid = false;
+			break;
+		}
+		position += header.nameLength;
+
+		typeLength = getTypeLength(header.type);
+		if (header.isNull
+				|| (typeLength >= 0 && typeLength <= SIZEOF_DATUM))
+		{
+			isValid = header.contentSize == 0;
+		}
+		else if (header.contentSize == 0
+				|| header.contentSize > (Size) (end - position))
+		{
+			isValid = false;
+		}
+		else if (typeLength > 0)
+		{
+			isValid = header.contentSize == (Size) typeLength;
+		}
+		else if (typeLength == -1)
+		{
+			if (VARATT_IS_EXTERNAL(position))
+			{
+				isValid = false;
+			}
+			else if (VARATT_IS_1B(position))
+			{
+				isValid = header.contentSize == VARSIZE_1B(position);
+			}
+			else
+			{
+				isValid = header.contentSize >= VARHDRSZ
+						&& header.contentSize == VARSIZE_4B(position);
+			}
+		}
+		else
 		{
-			*found = false;
-			return *lvl;
+			isValid = memchr(position, '\0', header.contentSize)
+					== position + header.contentSize - 1;
 		}
-		logVariable(DEBUG2, "not found (yet) search(next):", (*lvl));
-		return searchVariable(variableName, &(*lvl)->next, found);
+		position += header.contentSize;
 	}
 
-	*found = true;
-	logVariable(DEBUG2, "searchVariable() = ", *lvl);
-	return *lvl;
+	if (!isValid || position != end)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED), (errmsg("serialized session variables are corrupt"))));
+	}
 }
 
 /*
- * Stores the variable with the specified data in memory and in the session_variable.variables table
+ * Creates the variables that serializeVariables() has written, preceded by
+ * their number, after checking them with checkSerializedVariables()
  *
- * @param text* variableName: Name of the variable to be stored
- * @param bool isConst: Is this variable to be treated as constant
- * @param Oid valueType: Data type of the variable content
- * @param int typeLength: Is this a variable length data type
- * @param bool isNull: Is the content NULL
- * @param Datum value: The value of the variable, may be NULL
- * @return bool: true if ok
+ * @param char* state - The serialized variables
+ * @param Size stateLength - The length of state in bytes
+ * @param int* nrVariables - Is set to the number of variables
+ * @return SessionVariable* - The variables as a list in name order
  */
-bool saveNewVariable(text* variableName, bool isConst, Oid valueType,
-		int typeLength, bool isNull, Datum value)
+SessionVariable* restoreVariables(char* state, Size stateLength,
+		int* nrVariables)
 {
-	bool found;
-	SessionVariable* parentLevel;
+	char* position = state;
+	SessionVariable* list = NULL;
+	SessionVariable** nextVar = &list;
 	SessionVariable* variable;
-	char* varName = text_to_cstring((text*) variableName);
+	ParallelStateVariable header;
+	text* variableName;
+	Datum content;
+	int i;
 
-	parentLevel = searchVariable(varName, &variables, &found);
-	if (found)
+	checkSerializedVariables(state, stateLength);
+
+	memcpy(nrVariables, position, sizeof(*nrVariables));
+	position += sizeof(*nrVariables);
+
+	for (i = 0; i < *nrVariables; i++)
 	{
-		if (value && (typeLength < 0 || typeLength > SIZEOF_DATUM))
+		memcpy(&header, position, sizeof(header));
+		position += sizeof(header);
+		variableName = cstring_to_text_with_len(position, header.nameLength);
+		position += header.nameLength;
+
+		content = header.content;
+		if (header.contentSize > 0)
 		{
 			/*
-			 * The value has been malloced instead of palloced, so must be freed if an error occurs.
+			 * createVariable() wants the content to be malloced
 			 */
-			free((void*) value);
+			content = PointerGetDatum(malloc(header.contentSize));
+			if (DatumGetPointer(content) == NULL)
+			{
+				ereport(ERROR,
+						(errcode(ERRCODE_OUT_OF_MEMORY), errmsg("out of memory")));
+			}
+			memcpy(DatumGetPointer(content), position, header.contentSize);
+			position += header.contentSize;
 		}
-		ereport(ERROR,
-				(errcode(ERRCODE_UNIQUE_VIOLATION) , (errmsg("Variable \"%s\" already exists", varName ))));
-		return false;
+
+		variable = createVariable(variableName, header.isConstant, header.type,
+				getTypeLength(header.type), header.isNull, content);
+		variable->isTransactionScoped = header.isTransactionScoped;
+		*nextVar = variable;
+		nextVar = &variable->next;
+		pfree(variableName);
+	}
+
+	return list;
+}
+
+/*
+ * Checks if a no-argument function called session_variable.initialze_variables()
+ * exists and, if so, invokes it.
+ */
+void invokeInitialisationFunction()
+{
+	Oid namespaceOid;
+	char* dbName;
+
+	dbName = get_database_name(MyDatabaseId);
+	namespaceOid = get_namespace_oid("session_variable", true);
+	if (OidIsValid(namespaceOid))
+	{
+		/*
+		 * Check if a no-argument function called "variable_initialisation" exists in namespace
+		 * "session_variable"
+		 */
+		oidvector* emptyArgVector = buildoidvector(NULL, 0);
+		if (SearchSysCacheExists3(PROCNAMEARGSNSP,
+				CStringGetDatum("variable_initialisation"),
+				PointerGetDatum(buildoidvector(NULL, 0)),
+				ObjectIdGetDatum(namespaceOid)))
+		{
+
+			SPI_connect();
+
+			elog(
+					DEBUG3,
+					"login_hook will execute select session_variable.variable_initialisation() in database %s",
+					dbName);
+			isExecutingInitialisationFunction = true;
+			SPI_execute("select session_variable.variable_initialisation()",
+			false, 1);
+			isExecutingInitialisationFunction = false;
+			elog(
+					DEBUG3,
+					"login_hook is back from select session_variable.variable_initialisation() in database %s",
+					dbName);
+
+			SPI_finish();
+		}
+		else
+		{
+			elog(
+					DEBUG1,
+					"Function session_variable.variable_initialisation() is not invoked because it does not exist in database %s",
+					dbName);
+		}
+
+		pfree(emptyArgVector);
+	}
+}
+
+/*
+ * function session_variable.is_executing_variable_initialisation() returns boolean.
+ *
+ * This function returns true if the session_variable.variable_initialisation() function is executing
+ * under control of the session_variable code.
+ */
+PG_FUNCTION_INFO_V1(is_executing_variable_initialisation);
+PGDLLEXPORT Datum is_executing_variable_initialisation( PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(isExecutingInitialisationFunction);
+}
+
+/*
+ * Converts the content of the variable to a text Datum using the type's
+ * outfunction.
+ *
+ * @param SessionVariable* variable - The variable of which the content is to be
+ *                                    serialized
+ * @return Datum - The initial value serialized using the type's outfunction
+ *                 or null if the variable's content was null
+ */
+Datum serializeV2(SessionVariable* variable)
+{
+	HeapTuple typTup;
+	Form_pg_type typ;
+	Oid typOutputFunctionOid;
+	char* serialized;
+	Datum result;
+
+	if (variable->isNull)
+	{
+		return (Datum) NULL;
+	}
+
+	/*
+	 * Get the type specs
+	 */
+	typTup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(variable->type));
+	if (!HeapTupleIsValid(typTup))
+	{
+		elog(ERROR, "cache lookup failed for type %u", variable->type);
+		return (Datum) NULL;
+	}
+	typ = (Form_pg_type) GETSTRUCT(typTup);
+	typOutputFunctionOid = typ->typoutput;
+	ReleaseSysCache(typTup);
+
+	/*
+	 * Serialize the initialValue into a character array
+	 */
+	serialized = OidOutputFunctionCall(typOutputFunctionOid, getContent(variable));
+	if (!serialized)
+	{
+		/*
+		 * something went wrong. Let's hope it is logged
+		 */
+		return (Datum) NULL;
+	}
+
+	/*
+	 * Wrap into a bytea
+	 */
+	result = (Datum) cstring_to_text(serialized);
+	pfree(serialized);
+
+	return result;
+}
+
+/*
+ * Inserts the variable into the session_variable.variables table, or defers
+ * the insert until the end of the transaction, see deferWrite()
+ *
+ * @param SessionVariable* variable
+ * @return bool: true if ok
+ */
+bool insertVariable(SessionVariable* variable)
+{
+	Datum value = (Datum) NULL;
+
+	if (!variable->isNull)
+	{
+		value = serialize(variable);
+	}
+	if (deferWrite(PENDING_INSERT, variable->name, variable->isConstant,
+			variable->isTransactionScoped, variable->type, variable->isNull,
+			value))
+	{
+		return true;
+	}
+	return executeInsert(variable->name, variable->isConstant,
+			variable->isTransactionScoped, variable->type, variable->isNull,
+			value);
+}
+
+/*
+ * Inserts a row into the session_variable.variables table. The variable_scope
+ * column only exists once the extension is updated to this version, before
+ * that all variables are session scoped.
+ *
+ * @param char* variableName - Name of the variable
+ * @param bool isConst - Is the variable a constant
+ * @param bool isTransactionScoped - Is the variable reset at the end of each
+ *                                   transaction
+ * @param Oid valueType - The type of the variable
+ * @param bool isNull - Is the initial value null
+ * @param Datum value - The serialized initial value, ignored if isNull
+ * @return bool: true if ok
+ */
+bool executeInsert(char* variableName, bool isConst, bool isTransactionScoped,
+		Oid valueType, bool isNull, Datum value)
+{
+	char* sql = "insert into session_variable.variables "
+			"( variable_name"
+			", is_constant"
+			", variable_type_namespace"
+			", variable_type_name"
+			", initial_value"
+			", variable_scope"
+			") "
+			"select $1"
+			", $2"
+			", nsp.nspname"
+			", typ.typname"
+			", $4"
+			", $5 "
+			"from pg_catalog.pg_type typ "
+			"join pg_catalog.pg_namespace nsp on typ.typnamespace = nsp.oid "
+			"where typ.oid = $3";
+	char* sqlWithoutScope = "insert into session_variable.variables "
+			"( variable_name"
+			", is_constant"
+			", variable_type_namespace"
+			", variable_type_name"
+			", initial_value"
+			") "
+			"select $1"
+			", $2"
+			", nsp.nspname"
+			", typ.typname"
+			", $4 "
+			"from pg_catalog.pg_type typ "
+			"join pg_catalog.pg_namespace nsp on typ.typnamespace = nsp.oid "
+			"where typ.oid = $3";
+	size_t nrArgs = 5;
+	Oid* oid;
+	Datum* val;
+	char* nulls;
+	bool result;
+
+	oid = (Oid*)palloc(sizeof(Oid) * nrArgs);
+	val = (Datum*)palloc(sizeof(Datum) * nrArgs);
+	nulls = (char*)palloc(sizeof(char) * nrArgs);
+
+	oid[0] = TEXTOID;
+	val[0] = (Datum) cstring_to_text(variableName);
+	nulls[0] = ' ';
+	oid[1] = BOOLOID;
+	val[1] = BoolGetDatum(isConst);
+	nulls[1] = ' ';
+	oid[2] = REGTYPEOID;
+	val[2] = ObjectIdGetDatum(valueType);
+	nulls[2] = ' ';
+	oid[3] = initialValueTypeOid;
+	if (isNull)
+	{
+		val[3] = PointerGetDatum(NULL);
+		nulls[3] = 'n';
+	}
+	else
+	{
+		val[3] = value;
+		nulls[3] = ' ';
+	}
+	oid[4] = TEXTOID;
+	val[4] = PointerGetDatum(
+			cstring_to_text(isTransactionScoped ? "transaction" : "session"));
+	nulls[4] = ' ';
+
+	if (!isInstalledVersionCurrent())
+	{
+		if (isTransactionScoped)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), (errmsg("transaction scoped variables require version %s of the extension", sessionVariableVersion))));
+		}
+		sql = sqlWithoutScope;
+		nrArgs = 4;
+	}
+
+	SPI_connect();
+	result = SPI_execute_with_args(sql, nrArgs, oid, val, nulls, false, 1);
+	SPI_finish();
+
+	pfree(oid);
+	pfree(val);
+	pfree(nulls);
+
+	return result;
+}
+
+/*
+ * Updates the variable's initial value in the session_variable.variables
+ * table, or defers the update until the end of the transaction, see
+ * deferWrite()
+ *
+ * @param SessionVariable* variable
+ */
+void updateVariable(SessionVariable* variable)
+{
+	Datum value = (Datum) NULL;
+
+	if (!variable->isNull)
+	{
+		value = serialize(variable);
+	}
+	if (!deferWrite(PENDING_UPDATE, variable->name, variable->isConstant,
+			variable->isTransactionScoped, variable->type, variable->isNull,
+			value))
+	{
+		executeUpdate(variable->name, variable->isNull, value);
+	}
+}
+
+/*
+ * Updates the initial value of a row in the session_variable.variables table
+ *
+ * @param char* variableName - Name of the variable
+ * @param bool isNull - Is the initial value null
+ * @param Datum value - The serialized initial value, ignored if isNull
+ */
+void executeUpdate(char* variableName, bool isNull, Datum value)
+{
+	char* sql = "update session_variable.variables"
+			" set initial_value = $1"
+			" where variable_name = $2";
+	static const size_t nrArgs = 2;
+	Oid* oid;
+	Datum* val;
+	char* nulls;
+
+	oid = (Oid*)palloc(sizeof(Oid) * nrArgs);
+	val = (Datum*)palloc(sizeof(Datum) * nrArgs);
+	nulls = (char*)palloc(sizeof(char) * nrArgs);
+
+	oid[0] = initialValueTypeOid;
+	if (isNull)
+	{
+		val[0] = PointerGetDatum(NULL);
+		nulls[0] = 'n';
+	}
+	else
+	{
+		val[0] = value;
+		nulls[0] = ' ';
+	}
+
+	oid[1] = TEXTOID;
+	val[1] = (Datum) cstring_to_text(variableName);
+	nulls[1] = ' ';
+
+	SPI_connect();
+	SPI_execute_with_args(sql, nrArgs, oid, val, nulls, false, 1);
+	SPI_finish();
+
+	pfree(oid);
+	pfree(val);
+	pfree(nulls);
+}
+
+/*
+ * Deletes the variable from the session_variable.variables table, or defers
+ * the delete until the end of the transaction, see deferWrite()
+ *
+ * @param text* variableName
+ */
+void deleteVariable(text* variableName)
+{
+	char* name = text_to_cstring(variableName);
+
+	if (!deferWrite(PENDING_DELETE, name, false, false, InvalidOid, true,
+			(Datum) NULL))
+	{
+		executeDelete(name);
+	}
+	pfree(name);
+}
+
+/*
+ * Deletes a row from the session_variable.variables table
+ *
+ * @param char* variableName - Name of the variable
+ */
+void executeDelete(char* variableName)
+{
+	char* sql =
+			"delete from session_variable.variables where variable_name = $1";
+	const size_t nrArgs = 1;
+	Oid* oid;
+	Datum* val;
+
+	oid = (Oid*)palloc(sizeof(Oid) * nrArgs);
+	val = (Datum*)palloc(sizeof(Datum) * nrArgs);
+
+	oid[0] = TEXTOID;
+	val[0] = (Datum) cstring_to_text(variableName);
+
+	SPI_connect();
+	SPI_execute_with_args(sql, nrArgs, oid, val, NULL, false, 1);
+	SPI_finish();
+
+	pfree(oid);
+	pfree(val);
+}
+
+/*
+ * Defines session_variable.defer_writes. Invoked from _PG_init().
+ */
+void defineDeferredWrites(void)
+{
+	DefineCustomBoolVariable("session_variable.defer_writes",
+			"Writes the changes of create_variable(), create_constant(), alter_value() and drop() at commit, one write per variable.",
+			NULL, &deferWrites, false, PGC_USERSET, 0, NULL, NULL, NULL);
+}
+
+/*
+ * Hash function of pendingWrites, the key is a pointer to the variable name
+ */
+uint32 pendingWriteHash(const void* key, Size keySize)
+{
+	char* variableName = *((char* const *) key);
+
+	return DatumGetUInt32(
+			hash_any((unsigned char*) variableName, strlen(variableName)));
+}
+
+/*
+ * Match function of pendingWrites, the keys are pointers to variable names
+ */
+int pendingWriteMatch(const void* key1, const void* key2, Size keySize)
+{
+	return strcmp(*((char* const *) key1), *((char* const *) key2));
+}
+
+/*
+ * Registers a write to the session_variable.variables table, to be executed
+ * just before the transaction commits, if session_variable.defer_writes is on
+ * or if writes of this transaction have been deferred already. The writes of
+ * a variable are coalesced: the row is deleted if it existed before the
+ * transaction and has been dropped, and then inserted if the variable has been
+ * (re)created, or else updated if its value has been altered. So a variable
+ * that is created and dropped in the same transaction is not written at all.
+ * The writes before the first change in a subtransaction are saved, to be
+ * restored if the subtransaction is rolled back.
+ *
+ * @param PendingWriteType operation - The write to register
+ * @param char* variableName - Name of the variable
+ * @param bool isConst - Is the variable a constant, for PENDING_INSERT
+ * @param bool isTransactionScoped - Is the variable reset at the end of each
+ *                                   transaction, for PENDING_INSERT
+ * @param Oid valueType - The type of the variable, for PENDING_INSERT
+ * @param bool isNull - Is the initial value null
+ * @param Datum value - The serialized initial value, ignored if isNull
+ * @return bool - true if the write has been deferred
+ */
+bool deferWrite(PendingWriteType operation, char* variableName, bool isConst,
+		bool isTransactionScoped, Oid valueType, bool isNull, Datum value)
+{
+	HASHCTL info;
+	PendingWrite* write;
+	PendingWrite* saved;
+	bool found;
+	MemoryContext oldContext;
+	SubTransactionId subTransactionId = GetCurrentSubTransactionId();
+
+	if (!deferWrites && pendingWrites == NULL)
+	{
+		return false;
+	}
+
+	if (!pendingWritesCallbackRegistered)
+	{
+		RegisterXactCallback(pendingWritesXactCallback, NULL);
+		RegisterSubXactCallback(pendingWritesSubXactCallback, NULL);
+		pendingWritesCallbackRegistered = true;
+	}
+
+	oldContext = MemoryContextSwitchTo(TopTransactionContext);
+	if (pendingWrites == NULL)
+	{
+		memset(&info, 0, sizeof(info));
+		info.keysize = sizeof(char*);
+		info.entrysize = sizeof(PendingWrite);
+		info.hash = pendingWriteHash;
+		info.match = pendingWriteMatch;
+		info.hcxt = TopTransactionContext;
+		pendingWrites = hash_create("session_variable pending writes", 64,
+				&info, HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+	}
+
+	write = (PendingWrite*) hash_search(pendingWrites, &variableName,
+			HASH_ENTER, &found);
+	if (!found)
+	{
+		write->variableName = pstrdup(variableName);
+		write->deleteRow = false;
+		write->insertRow = false;
+		write->updateRow = false;
+		write->isNull = true;
+		write->subTransactionId = subTransactionId;
+		write->saved = NULL;
+	}
+	else if (write->subTransactionId != subTransactionId)
+	{
+		saved = (PendingWrite*) palloc(sizeof(PendingWrite));
+		memcpy(saved, write, sizeof(PendingWrite));
+		if (!write->isNull)
+		{
+			saved->value = datumCopy(write->value, false, -1);
+		}
+		write->subTransactionId = subTransactionId;
+		write->saved = saved;
+	}
+
+	switch (operation)
+	{
+	case PENDING_INSERT:
+		write->insertRow = true;
+		write->isConstant = isConst;
+		write->isTransactionScoped = isTransactionScoped;
+		write->type = valueType;
+		break;
+	case PENDING_UPDATE:
+		write->updateRow = !write->insertRow;
+		break;
+	case PENDING_DELETE:
+		if (write->insertRow)
+		{
+			write->insertRow = false;
+		}
+		else
+		{
+			write->deleteRow = true;
+		}
+		write->updateRow = false;
+		break;
+	}
+
+	if (operation != PENDING_DELETE)
+	{
+		if (!write->isNull)
+		{
+			pfree(DatumGetPointer(write->value));
+		}
+		write->isNull = isNull;
+		if (!isNull)
+		{
+			write->value = datumCopy(value, false, -1);
+		}
+	}
+	MemoryContextSwitchTo(oldContext);
+
+	elog(DEBUG2, "deferWrite(%d, '%s')", operation, variableName);
+	return true;
+}
+
+/*
+ * Applies the deferred writes of the transaction to variables that have just
+ * been loaded from the session_variable.variables table, so a load in the
+ * middle of the transaction need not execute them, see deferWrite(). The
+ * variables of which the row is to be deleted, replaced or updated are
+ * removed from the list and the ones of which the row is to be inserted or
+ * updated are added with the pending initial value.
+ *
+ * @param SessionVariable* list - The loaded variables, ordered by name
+ * @param char* name - The name of the loaded variable, or the group prefix
+ * @param bool isPrefix - Were all variables that start with name loaded
+ * @param int* nrVariables - Is adjusted to the number of variables
+ * @return SessionVariable* - The variables, ordered by name
+ */
+SessionVariable* applyPendingWrites(SessionVariable* list, char* name,
+		bool isPrefix, int* nrVariables)
+{
+	HASH_SEQ_STATUS status;
+	PendingWrite* write;
+	SessionVariable** link = &list;
+	SessionVariable* variable;
+	SessionVariable* added = NULL;
+	char* variableName;
+	int nameLength = strlen(name);
+
+	if (pendingWrites == NULL)
+	{
+		return list;
+	}
+
+	while (*link != NULL)
+	{
+		variable = *link;
+		variableName = variable->name;
+		write = (PendingWrite*) hash_search(pendingWrites, &variableName,
+				HASH_FIND, NULL);
+		if (write == NULL
+				|| !(write->deleteRow || write->insertRow || write->updateRow))
+		{
+			link = &variable->next;
+			continue;
+		}
+
+		*link = variable->next;
+		variable->next = NULL;
+		if (write->updateRow)
+		{
+			added = mergeVariableLists(added,
+					pendingVariable(write, variable->isConstant,
+							variable->isTransactionScoped, variable->type));
+		}
+		else
+		{
+			(*nrVariables)--;
+		}
+		removeVariableRecursively(variable);
+	}
+
+	hash_seq_init(&status, pendingWrites);
+	while ((write = (PendingWrite*) hash_seq_search(&status)) != NULL)
+	{
+		if (write->insertRow
+				&& (isPrefix ?
+						strncmp(write->variableName, name, nameLength) == 0 :
+						strcmp(write->variableName, name) == 0))
+		{
+			added = mergeVariableLists(added,
+					pendingVariable(write, write->isConstant,
+							write->isTransactionScoped, write->type));
+			(*nrVariables)++;
+		}
+	}
+
+	return mergeVariableLists(list, added);
+}
+
+/*
+ * Creates a variable with the initial value of a deferred write
+ *
+ * @param PendingWrite* write - The deferred insert or update
+ * @param bool isConst - Is the variable a constant
+ * @param bool isTransactionScoped - Is the variable transaction scoped
+ * @param Oid valueType - The type of the variable
+ * @return SessionVariable* - The new variable, not linked
+ */
+SessionVariable* pendingVariable(PendingWrite* write, bool isConst,
+		bool isTransactionScoped, Oid valueType)
+{
+	text* variableName = cstring_to_text(write->variableName);
+	int typeLength = getTypeLength(valueType);
+	SessionVariable* variable;
+	Datum value;
+	bool castFailed;
+
+	variable = createVariable(variableName, isConst, valueType, typeLength,
+			true, (Datum) NULL);
+	variable->isTransactionScoped = isTransactionScoped;
+	if (!write->isNull)
+	{
+		value = deserialize(variableName, valueType, write->value);
+		variable->content = coerceInput(valueType, valueType, typeLength,
+				value, inlineContent(variable), &castFailed);
+		variable->isNull = false;
+	}
+	pfree(variableName);
+	return variable;
+}
+
+/*
+ * Executes the deferred writes, see deferWrite(). Invoked just before the
+ * transaction commits and before the session_variable.variables table is read.
+ */
+void flushPendingWrites(void)
+{
+	HTAB* writes = pendingWrites;
+	HASH_SEQ_STATUS status;
+	PendingWrite* write;
+
+	if (writes == NULL)
+	{
+		return;
+	}
+	pendingWrites = NULL;
+
+	hash_seq_init(&status, writes);
+	while ((write = (PendingWrite*) hash_seq_search(&status)) != NULL)
+	{
+		if (write->deleteRow)
+		{
+			executeDelete(write->variableName);
+		}
+		if (write->insertRow)
+		{
+			executeInsert(write->variableName, write->isConstant,
+					write->isTransactionScoped, write->type, write->isNull,
+					write->value);
+		}
+		else if (write->updateRow)
+		{
+			executeUpdate(write->variableName, write->isNull, write->value);
+		}
+	}
+	hash_destroy(writes);
+}
+
+/*
+ * Restores the deferred writes as they were before a subtransaction that is
+ * rolled back, including the ones of its committed subtransactions
+ */
+void pendingWritesSubXactCallback(SubXactEvent event,
+		SubTransactionId mySubid, SubTransactionId parentSubid, void* arg)
+{
+	HASH_SEQ_STATUS status;
+	PendingWrite* write;
+	PendingWrite* saved;
+
+	if (event != SUBXACT_EVENT_ABORT_SUB || pendingWrites == NULL)
+	{
+		return;
+	}
+
+	hash_seq_init(&status, pendingWrites);
+	while ((write = (PendingWrite*) hash_seq_search(&status)) != NULL)
+	{
+		/*
+		 * The saved writes are newest first and subtransaction ids only grow
+		 * within a transaction
+		 */
+		saved = write;
+		while (saved != NULL && saved->subTransactionId >= mySubid)
+		{
+			saved = saved->saved;
+		}
+		if (saved == write)
+		{
+			continue;
+		}
+
+		if (saved == NULL)
+		{
+			hash_search(pendingWrites, &write->variableName, HASH_REMOVE,
+					NULL);
+		}
+		else
+		{
+			/*
+			 * The discarded copies are freed with the TopTransactionContext
+			 */
+			memcpy(write, saved, sizeof(PendingWrite));
+		}
+	}
+}
+
+/*
+ * Flushes the deferred writes before the transaction commits or is prepared,
+ * forgets them when it aborts.
+ */
+void pendingWritesXactCallback(XactEvent event, void* arg)
+{
+	switch (event)
+	{
+	case XACT_EVENT_PRE_COMMIT:
+	case XACT_EVENT_PRE_PREPARE:
+		flushPendingWrites();
+		break;
+	case XACT_EVENT_ABORT:
+		/*
+		 * The hash table is freed with the TopTransactionContext
+		 */
+		pendingWrites = NULL;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Defines session_variable.bound_variables and, for each variable in it, the
+ * setting session_variable.<variable name>. The setting can then be given in
+ * the options of a connection or with SET and SET LOCAL, the variable gets its
+ * value when it is used next, see applyBoundSettings(). Invoked from
+ * _PG_init().
+ */
+void defineBoundSettings(void)
+{
+	static const char* const ownSettings[] = {"bound_variables",
+			"compression", "compression_threshold", "defer_writes",
+			"lazy_load_groups", "parallel_state", "preload_database",
+			"shared_constants_max", "stats_flush_interval", "stats_max"};
+	MemoryContext oldContext;
+	List* names;
+	ListCell* cell;
+	char* variableName;
+	BoundSetting* binding;
+	int i;
+
+	DefineCustomStringVariable("session_variable.bound_variables",
+			"Variables that can be set with a setting session_variable.<variable name>, read when the library is loaded.",
+			NULL, &boundVariables, NULL, PGC_SUSET, GUC_LIST_INPUT, NULL, NULL,
+			NULL);
+	if (boundVariables == NULL || boundSettings != NULL)
+	{
+		return;
+	}
+
+	/*
+	 * The GUC mechanism keeps pointers to the names and descriptions
+	 */
+	oldContext = MemoryContextSwitchTo(TopMemoryContext);
+
+	if (!SplitIdentifierString(pstrdup(boundVariables), ',', &names))
+	{
+		ereport(WARNING,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("session_variable.bound_variables is not a valid list of variable names"))));
+		MemoryContextSwitchTo(oldContext);
+		return;
+	}
+
+	boundSettings = palloc0(Max(list_length(names), 1) * sizeof(BoundSetting));
+	foreach(cell, names)
+	{
+		variableName = (char*) lfirst(cell);
+
+		/*
+		 * The name of a setting is case insensitive and may only contain
+		 * letters, digits and underscores
+		 */
+		if (strspn(variableName, "abcdefghijklmnopqrstuvwxyz0123456789_")
+				!= strlen(variableName) || (*variableName >= '0' && *variableName <= '9'))
+		{
+			ereport(WARNING,
+					(errcode(ERRCODE_INVALID_NAME), (errmsg("variable \"%s\" cannot be bound to a setting, the name may only contain lower case letters, digits and underscores", variableName))));
+			continue;
+		}
+		for (i = 0; i < lengthof(ownSettings); i++)
+		{
+			if (strcmp(variableName, ownSettings[i]) == 0)
+			{
+				break;
+			}
+		}
+		if (i < lengthof(ownSettings))
+		{
+			ereport(WARNING,
+					(errcode(ERRCODE_DUPLICATE_OBJECT), (errmsg("variable \"%s\" cannot be bound to a setting, session_variable.%s is a setting of session_variable itself", variableName, variableName))));
+			continue;
+		}
+
+		binding = &boundSettings[nrBoundSettings++];
+		binding->variableName = variableName;
+		DefineCustomStringVariable(psprintf("session_variable.%s", variableName),
+				psprintf("Sets session variable %s.", variableName), NULL,
+				&binding->value, NULL, PGC_USERSET, 0, NULL, assignBoundSetting,
+				NULL);
+	}
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * Assign hook of the settings of bound variables. An assign hook may not fail
+ * and may be invoked outside a transaction, so the variables are set when
+ * they are used next.
+ */
+void assignBoundSetting(const char* newValue, void* extra)
+{
+	boundSettingsChanged = true;
+}
+
+/*
+ * Sets each bound variable of which the setting has changed since it was
+ * applied last to the value of the setting, or to its initial value in the
+ * catalog if the setting is reset to its default, as set() does. Invoked from
+ * searchVariable().
+ */
+void applyBoundSettings(void)
+{
+	BoundSetting* binding;
+	SessionVariable* variable;
+	SessionVariable* initial;
+	bool found;
+	Oid inputFunctionOid;
+	Oid typeIOParam;
+	Datum value;
+	Datum args[1];
+	int nrVariables;
+	int i;
+
+	boundSettingsChanged = false;
+
+	/*
+	 * A parallel worker gets the variables with the settings applied from its
+	 * leader
+	 */
+	if (IsParallelWorker())
+	{
+		return;
+	}
+
+	for (i = 0; i < nrBoundSettings; i++)
+	{
+		binding = &boundSettings[i];
+		if (binding->value == NULL ?
+				binding->appliedValue == NULL :
+				binding->appliedValue != NULL
+						&& strcmp(binding->value, binding->appliedValue) == 0)
+		{
+			continue;
+		}
+
+		/*
+		 * Registered before the value is converted, so an invalid value is
+		 * reported only once
+		 */
+		if (binding->appliedValue != NULL)
+		{
+			pfree(binding->appliedValue);
+		}
+		binding->appliedValue = binding->value == NULL ?
+				NULL : MemoryContextStrdup(TopMemoryContext, binding->value);
+
+		variable = searchVariable(binding->variableName, &variables, &found);
+		if (!found || variable->isConstant)
+		{
+			ereport(WARNING,
+					(errcode(ERRCODE_NO_DATA_FOUND), (errmsg("setting session_variable.%s is ignored, variable \"%s\" does not exists", binding->variableName, binding->variableName))));
+			continue;
+		}
+
+		if (binding->value == NULL)
+		{
+			/*
+			 * The initial value includes the override of this session, if any
+			 */
+			nrVariables = 0;
+			args[0] = CStringGetTextDatum(variable->name);
+			initial = applyPendingWrites(
+					loadVariables("var.variable_name = $1", 1, args,
+							&nrVariables), variable->name, false, &nrVariables);
+			if (initial == NULL || initial->isNull)
+			{
+				setValue(variable, variable->type, true, (Datum) 0);
+			}
+			else
+			{
+				setValue(variable, initial->type, false, getContent(initial));
+			}
+			removeVariableRecursively(initial);
+		}
+		else
+		{
+			getTypeInputInfo(variable->type, &inputFunctionOid, &typeIOParam);
+			value = OidInputFunctionCall(inputFunctionOid, binding->value,
+					typeIOParam, -1);
+			setValue(variable, variable->type, false, value);
+		}
+		logVariable(DEBUG2, "applyBoundSettings() set ", variable);
+	}
+}
+
+/*
+ * Makes the bound variables get the value of their setting again after they
+ * have been reloaded
+ */
+void forgetAppliedSettings(void)
+{
+	int i;
+
+	for (i = 0; i < nrBoundSettings; i++)
+	{
+		if (boundSettings[i].appliedValue != NULL)
+		{
+			pfree(boundSettings[i].appliedValue);
+			boundSettings[i].appliedValue = NULL;
+		}
+		boundSettingsChanged |= boundSettings[i].value != NULL;
+	}
+}
+
+/*
+ * Searches the binary tree for the variableName
+ *
+ * If a matching name is found, found wil be set to true and the var with the corresponding name will
+ * be returned.
+ *
+ * If no variables exist, NULL will be returned.
+ *
+ * Else found will be set to false and the variable under which the new variable is to be positioned
+ * will be returned. So if the variableName is less than the name in the returned variable, then the
+ * prior pointer of the returned variable will be NULL. Otherwise the next pointer of the returned
+ * variable will be NULL.
+ *
+ * @param char* variableName: Name to be found
+ * @param SessionVariable** lvl: The variables static variable or a parent level under which to search
+ * @param bool* found: Will be set true if the variableName is found or false if not
+ * @return SessionVariable*: If found == true, the var that we were looking for.
+ *              else the var under which the new variable should be stored of null if no variables exist yet.
+ */
+SessionVariable* searchVariable(char* variableName, SessionVariable** lvl,
+		bool* found)
+{
+	SessionVariable* variable;
+	int nameLength = strlen(variableName);
+	int diff;
+
+	elog(DEBUG2, "searchVariable('%s')", variableName);
+
+	if (boundSettingsChanged && lvl == &variables)
+	{
+		applyBoundSettings();
+	}
+	variable = *lvl;
+
+	*found = false;
+	while (variable != NULL)
+	{
+		/*
+		 * Same order as strcmp(), but without looking for the terminating zeroes
+		 */
+		diff = memcmp(variableName, variable->name,
+				Min(nameLength, variable->nameLength));
+		if (diff == 0)
+		{
+			diff = nameLength - variable->nameLength;
+		}
+
+		if (diff < 0)
+		{
+			if (variable->prior == NULL)
+			{
+				break;
+			}
+			logVariable(DEBUG2, "not found (yet) search(prior):", variable);
+			variable = variable->prior;
+		}
+		else if (diff > 0)
+		{
+			if (variable->next == NULL)
+			{
+				break;
+			}
+			logVariable(DEBUG2, "not found (yet) search(next):", variable);
+			variable = variable->next;
+		}
+		else
+		{
+			*found = true;
+			logVariable(DEBUG2, "searchVariable() = ", variable);
+			return variable;
+		}
+	}
+
+	/*
+	 * The variable may be in a group that has not been loaded yet
+	 */
+	if (lvl == &variables && loadGroup(variableName))
+	{
+		return searchVariable(variableName, lvl, found);
+	}
+
+	elog(DEBUG2, "searchVariable(%s) = not found", variableName);
+	return variable;
+}
+
+/*
+ * Stores the variable with the specified data in memory and in the session_variable.variables table
+ *
+ * @param text* variableName: Name of the variable to be stored
+ * @param bool isConst: Is this variable to be treated as constant
+ * @param bool isTransactionScoped: Is the variable reset at the end of each transaction
+ * @param Oid valueType: Data type of the variable content
+ * @param int typeLength: Is this a variable length data type
+ * @param bool isNull: Is the content NULL
+ * @param Datum value: The value of the variable, may be NULL
+ * @return bool: true if ok
+ */
+bool saveNewVariable(text* variableName, bool isConst,
+		bool isTransactionScoped, Oid valueType, int typeLength, bool isNull,
+		Datum value)
+{
+	bool found;
+	SessionVariable* parentLevel;
+	SessionVariable* variable;
+	char* varName = text_to_cstring((text*) variableName);
+
+	parentLevel = searchVariable(varName, &variables, &found);
+	if (found)
+	{
+		if (value && (typeLength < 0 || typeLength > SIZEOF_DATUM))
+		{
+			/*
+			 * The value has been malloced instead of palloced, so must be freed if an error occurs.
+			 */
+			free((void*) value);
+		}
+		ereport(ERROR,
+				(errcode(ERRCODE_UNIQUE_VIOLATION) , (errmsg("Variable \"%s\" already exists", varName ))));
+		return false;
 	}
 
 	variable = createVariable(variableName, isConst, valueType, typeLength,
 			isNull, value);
+	variable->isTransactionScoped = isTransactionScoped;
+
+	if (parentLevel == NULL)
+	{
+		variables = variable;
+	}
+	else
+	{
+		int diff = strcmp(varName, parentLevel->name);
+
+		if (diff < 0)
+		{
+			parentLevel->prior = variable;
+		}
+		else
+		{
+			parentLevel->next = variable;
+		}
+	}
+	variableCount++;
+	stateVersion++;
+	rebalance(variable->name);
+
+	return insertVariable(variable);
+}
+
+/*
+ * create_variable(variable_name text, variable_type regtype) returns boolean
+ * create_variable(variable_name text, variable_type regtype, initial_value anyelement) returns boolean
+ * create_variable(variable_name text, variable_type regtype, initial_value anyelement, variable_scope text) returns boolean
+ */
+PG_FUNCTION_INFO_V1(create_variable);
+PGDLLEXPORT Datum create_variable( PG_FUNCTION_ARGS)
+{
+	text* variableName = NULL;
+	Oid type = InvalidOid;
+	Oid typeOid = InvalidOid;
+	Datum content = (Datum) NULL;
+	Oid contentTypeOid;
+	int typeLength;
+	bool isNull = false;
+	bool isTransactionScoped = false;
+	bool result;
+	int contentTypeLength;
+	bool castFailed;
+	char* variableNameStr;
+	char* scope;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_NARGS() < 2 || PG_NARGS() > 4)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.create_variable(variable_name text, variable_type regtype) " "or session_variable.create_variable(variable_name text, variable_type regtype, initial_value anyelement) " "or session_variable.create_variable(variable_name text, variable_type regtype, initial_value anyelement, variable_scope text)"))));
+		PG_RETURN_BOOL(false);
+	}
+
+	if (PG_NARGS() == 4 && !PG_ARGISNULL(3))
+	{
+		scope = text_to_cstring(PG_GETARG_TEXT_PP(3));
+		if (strcmp(scope, "transaction") == 0)
+		{
+			isTransactionScoped = true;
+		}
+		else if (strcmp(scope, "session") != 0)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("variable scope must be 'session' or 'transaction'"))));
+			PG_RETURN_BOOL(false);
+		}
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable name must be filled"))));
+		PG_RETURN_BOOL(false);
+	}
+	variableName = PG_GETARG_TEXT_P(0);
+
+	if (PG_ARGISNULL(1))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable type must be filled"))));
+		PG_RETURN_BOOL(false);
+	}
+	type = PG_GETARG_OID(1);
+	typeOid = DatumGetObjectId(type);
+	if (!checkTypeType(typeOid))
+	{
+		PG_RETURN_BOOL(false);
+	}
+	typeLength = getTypeLength(typeOid);
+
+	variableNameStr = text_to_cstring(variableName);
+	elog(DEBUG1, "@>create_variable('%s')", variableNameStr);
+	if (!strlen(variableNameStr))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	isNull = PG_NARGS() < 3 || PG_ARGISNULL(2);
+	if (!isNull)
+	{
+		contentTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 2);
+		if (typeOid == contentTypeOid)
+		{
+			contentTypeLength = typeLength;
+		}
+		else
+		{
+			contentTypeLength = getTypeLength(contentTypeOid);
+		}
+		if (contentTypeLength < 0)
+		{
+			content = (Datum) PG_GETARG_VARLENA_P(2);
+		}
+		else
+		{
+			content = PG_GETARG_DATUM(2);
+		}
+
+		/*
+		 * Make sure the new content is malloced instead of palloced, and cast to the right type of course.
+		 */
+		content = coerceInput(contentTypeOid, typeOid, typeLength, content,
+				NULL, &castFailed);
+		if (castFailed)
+		{
+			/*
+			 * Something went wrong, but that has already been logged
+			 */
+			PG_RETURN_BOOL(false);
+		}
+	}
+
+	result = saveNewVariable(variableName, false, isTransactionScoped, type,
+			typeLength, isNull, content);
+
+	elog(DEBUG1, "@<create_variable('%s')", variableNameStr);
+
+	PG_RETURN_BOOL(result);
+}
+
+/*
+ * create_constant(constant_name text, constant_type regtype, value anyelement) returns boolean
+ */
+PG_FUNCTION_INFO_V1(create_constant);
+PGDLLEXPORT Datum create_constant( PG_FUNCTION_ARGS)
+{
+	text* variableName = NULL;
+	Oid type = InvalidOid;
+	Oid typeOid = InvalidOid;
+	Datum content = (Datum) NULL;
+	Oid contentTypeOid;
+	int typeLength;
+	int contentTypeLength;
+	bool result;
+	bool castFailed;
+	char* variableNameStr;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_NARGS() != 3)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.create_constant(constant_name text, constant_type regtype, value anyelement)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("constant name must be filled"))));
+		PG_RETURN_BOOL(false);
+	}
+	variableName = PG_GETARG_TEXT_P(0);
+
+	if (PG_ARGISNULL(1))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("constant type must be filled"))));
+		PG_RETURN_BOOL(false);
+	}
+	type = PG_GETARG_OID(1);
+	typeOid = DatumGetObjectId(type);
+	if (!checkTypeType(typeOid))
+	{
+		PG_RETURN_BOOL(false);
+	}
+	typeLength = getTypeLength(typeOid);
+
+	variableNameStr = text_to_cstring(variableName);
+	elog(DEBUG1, "@>create_constant('%s')", variableNameStr);
+	if (!strlen(variableNameStr))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (!PG_ARGISNULL(2))
+	{
+		contentTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 2);
+		if (typeOid == contentTypeOid)
+		{
+			contentTypeLength = typeLength;
+		}
+		else
+		{
+			contentTypeLength = getTypeLength(contentTypeOid);
+		}
+		if (contentTypeLength < 0)
+		{
+			content = (Datum) PG_GETARG_VARLENA_P(2);
+		}
+		else
+		{
+			content = PG_GETARG_DATUM(2);
+		}
+
+		/*
+		 * Make sure the new content is malloced instead of palloced, and cast to the right type of course.
+		 */
+		content = coerceInput(contentTypeOid, typeOid, typeLength, content,
+				NULL, &castFailed);
+		if (castFailed)
+		{
+			/*
+			 * Something went wrong, but that has already been logged
+			 */
+			PG_RETURN_BOOL(false);
+		}
+	}
+
+	result = saveNewVariable(variableName, true, false, type, typeLength,
+			PG_ARGISNULL(2), content);
+
+	elog(DEBUG1, "@<create_constant('%s')", variableNameStr);
+
+	PG_RETURN_BOOL(result);
+}
+
+/*
+ * Orders import definitions by name, for qsort()
+ */
+int compareImportDefinitions(const void* a, const void* b)
+{
+	return strcmp(((const ImportDefinition*) a)->name,
+			((const ImportDefinition*) b)->name);
+}
+
+/*
+ * Merges two lists of variables, each ordered by name and linked by their next
+ * pointers, into one ordered list
+ *
+ * @param SessionVariable* list1 - The first list, may be NULL
+ * @param SessionVariable* list2 - The second list, may be NULL
+ * @return SessionVariable* - The head of the merged list
+ */
+SessionVariable* mergeVariableLists(SessionVariable* list1,
+		SessionVariable* list2)
+{
+	SessionVariable* head = NULL;
+	SessionVariable** tail = &head;
+
+	while (list1 != NULL && list2 != NULL)
+	{
+		if (strcmp(list1->name, list2->name) <= 0)
+		{
+			*tail = list1;
+			list1 = list1->next;
+		}
+		else
+		{
+			*tail = list2;
+			list2 = list2->next;
+		}
+		tail = &(*tail)->next;
+	}
+	*tail = list1 != NULL ? list1 : list2;
+	return head;
+}
+
+/*
+ * import(definitions variable_definition[]) returns integer
+ *
+ * Creates variables and constants in bulk. All definitions are validated
+ * before anything is changed, then they are inserted into the
+ * session_variable.variables table by a single statement and the b-tree is
+ * rebuilt once.
+ */
+PG_FUNCTION_INFO_V1(import);
+PGDLLEXPORT Datum import( PG_FUNCTION_ARGS)
+{
+	char* sql = "insert into session_variable.variables"
+			" ( variable_name"
+			" , is_constant"
+			" , variable_type_namespace"
+			" , variable_type_name"
+			" , initial_value"
+			" ) "
+			"select def.variable_name"
+			", coalesce(def.is_constant, false)"
+			", nsp.nspname"
+			", typ.typname"
+			", def.initial_value "
+			"from pg_catalog.unnest($1) def "
+			"join pg_catalog.pg_type typ on typ.oid = def.variable_type "
+			"join pg_catalog.pg_namespace nsp on typ.typnamespace = nsp.oid";
+	ArrayType* definitionArray;
+	Datum arrayDatum;
+	Oid arrayType;
+	Datum* elements;
+	bool* elementNulls;
+	int16 elementLength;
+	bool elementByValue;
+	char elementAlign;
+	int nrDefinitions;
+	ImportDefinition* definitions;
+	ImportDefinition* definition;
+	HeapTupleHeader row;
+	Datum attribute;
+	bool isNull;
+	bool found;
+	bool hasPendingWrites = false;
+	bool castFailed;
+	int typeLength;
+	SessionVariable* newVariables = NULL;
+	SessionVariable** nextVar = &newVariables;
+	SessionVariable* variable;
+	int spiResult;
+	int i;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("definitions must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+	arrayDatum = PG_GETARG_DATUM(0);
+	arrayType = get_fn_expr_argtype(fcinfo->flinfo, 0);
+	definitionArray = DatumGetArrayTypeP(arrayDatum);
+	get_typlenbyvalalign(ARR_ELEMTYPE(definitionArray), &elementLength,
+			&elementByValue, &elementAlign);
+	deconstruct_array(definitionArray, ARR_ELEMTYPE(definitionArray),
+			elementLength, elementByValue, elementAlign, &elements,
+			&elementNulls, &nrDefinitions);
+
+	elog(DEBUG1, "@>import(%d definitions)", nrDefinitions);
+
+	/*
+	 * Validate all definitions
+	 */
+	definitions = (ImportDefinition*) palloc0(
+			Max(nrDefinitions, 1) * sizeof(ImportDefinition));
+	for (i = 0; i < nrDefinitions; i++)
+	{
+		definition = &definitions[i];
+		if (elementNulls[i])
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable definition must be filled"))));
+		}
+		row = DatumGetHeapTupleHeader(elements[i]);
+
+		attribute = GetAttributeByNum(row, 1, &isNull);
+		if (isNull)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable name must be filled"))));
+		}
+		definition->name = TextDatumGetCString(attribute);
+		if (!strlen(definition->name))
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable name must be filled"))));
+		}
+
+		attribute = GetAttributeByNum(row, 2, &isNull);
+		if (isNull)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable type must be filled"))));
+		}
+		definition->type = DatumGetObjectId(attribute);
+		checkTypeType(definition->type);
+
+		attribute = GetAttributeByNum(row, 3, &isNull);
+		definition->isConstant = !isNull && DatumGetBool(attribute);
+
+		attribute = GetAttributeByNum(row, 4, &isNull);
+		definition->isNull = isNull;
+		if (!isNull)
+		{
+			definition->value = deserialize(cstring_to_text(definition->name),
+					definition->type, (Datum) PG_DETOAST_DATUM(attribute));
+		}
+	}
+
+	qsort(definitions, nrDefinitions, sizeof(ImportDefinition),
+			compareImportDefinitions);
+	for (i = 0; i < nrDefinitions; i++)
+	{
+		if (i > 0 && !strcmp(definitions[i].name, definitions[i - 1].name))
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_UNIQUE_VIOLATION) , (errmsg("Variable \"%s\" is defined more than once", definitions[i].name ))));
+		}
+		searchVariable(definitions[i].name, &variables, &found);
+		if (found)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_UNIQUE_VIOLATION) , (errmsg("Variable \"%s\" already exists", definitions[i].name ))));
+		}
+		hasPendingWrites |= pendingWrites != NULL
+				&& hash_search(pendingWrites, &definitions[i].name, HASH_FIND,
+						NULL) != NULL;
+	}
+
+	/*
+	 * Insert all definitions with a single statement, after the deferred
+	 * deletion of a variable with the same name
+	 */
+	if (hasPendingWrites)
+	{
+		flushPendingWrites();
+	}
+	SPI_connect();
+	spiResult = SPI_execute_with_args(sql, 1, &arrayType, &arrayDatum, NULL,
+			false, 0);
+	if (spiResult != SPI_OK_INSERT || SPI_processed != nrDefinitions)
+	{
+		elog(ERROR, "import of %d variables inserted %d rows, result %d",
+				nrDefinitions, (int) SPI_processed, spiResult);
+	}
+	SPI_finish();
+
+	/*
+	 * Merge the new variables, in name order, with the existing ones and
+	 * rebuild the b-tree
+	 */
+	for (i = 0; i < nrDefinitions; i++)
+	{
+		definition = &definitions[i];
+		typeLength = getTypeLength(definition->type);
+		variable = createVariable(cstring_to_text(definition->name),
+				definition->isConstant, definition->type, typeLength, true,
+				(Datum) NULL);
+		if (!definition->isNull)
+		{
+			variable->content = coerceInput(definition->type, definition->type,
+					typeLength, definition->value, inlineContent(variable),
+					&castFailed);
+			variable->isNull = false;
+		}
+		*nextVar = variable;
+		nextVar = &variable->next;
+	}
+	variables = buildBTree(
+			mergeVariableLists(flattenTree(variables), newVariables));
+	variableCount += nrDefinitions;
+	stateVersion++;
+
+	elog(DEBUG1, "@<import() = %d", nrDefinitions);
+
+	PG_RETURN_INT32(nrDefinitions);
+}
+
+/*
+ * drop(variable_constant_name text) returns boolean true
+ */
+PG_FUNCTION_INFO_V1(drop);
+PGDLLEXPORT Datum drop( PG_FUNCTION_ARGS)
+{
+	text* variableNameArg;
+	char* variableName;
+	SessionVariable *variable = NULL, **higherLvl, *replacement, *aboveReplacement;
+	int diff;
+	bool found;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_NARGS() != 1)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.drop(variable_or_constant_name text)"))));
+		PG_RETURN_BOOL(false);
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_BOOL(false);
+	}
+	variableNameArg = PG_GETARG_TEXT_P(0);
+	variableName = text_to_cstring(variableNameArg);
+
+	elog(DEBUG1, "@>drop('%s')", variableName);
+	if (!strlen(variableName))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	/*
+	 * Loads the group of the variable if that has not been loaded yet, see
+	 * loadGroup()
+	 */
+	searchVariable(variableName, &variables, &found);
+
+	higherLvl = &variables;
+	while (*higherLvl != NULL)
+	{
+		variable = *higherLvl;
+
+		diff = strcmp(variableName, variable->name);
+
+		if (diff < 0)
+		{
+			higherLvl = &variable->prior;
+			logVariable(DEBUG4, "searching: prior = ", variable);
+		}
+		else if (diff > 0)
+		{
+			higherLvl = &variable->next;
+			logVariable(DEBUG4, "searching: next = ", variable);
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (*higherLvl == NULL)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant \"%s\" does not exists", variableName ))));
+		PG_RETURN_BOOL(false);
+	}
+
+	logVariable(DEBUG4, "variable to drop = ", variable);
+	if (variable->prior == NULL)
+	{
+		*higherLvl = variable->next;
+	}
+	else if (variable->next == NULL)
+	{
+		*higherLvl = variable->prior;
+	}
+	else
+	{
+		aboveReplacement = NULL;
+		replacement = variable->prior;
+		while (replacement->next != NULL)
+		{
+			aboveReplacement = replacement;
+			replacement = replacement->next;
+		}
+		logVariable(DEBUG4, "replacement before = ", replacement);
+		logVariable(DEBUG4, "aboveReplacement before = ", replacement);
+		if (aboveReplacement != NULL)
+		{
+			aboveReplacement->next = replacement->prior;
+			logVariable(DEBUG4, "aboveReplacement after = ", aboveReplacement);
+		}
+		if (variable->prior != replacement)
+		{
+			replacement->prior = variable->prior;
+		}
+		replacement->next = variable->next;
+		*higherLvl = replacement;
+		logVariable(DEBUG4, "replacement after = ", replacement);
+	}
+
+	flushStatistics();
+	if (variable->isConstant)
+	{
+		queueSharedConstantChange(variable->name, true, 0);
+	}
+	forgetTransactionScopedValue(variable);
+	variable->prior = NULL;
+	variable->next = NULL;
+	removeVariableRecursively(variable);
+	variableCount--;
+	stateVersion++;
+	handleGeneration++;
+
+	deleteVariable(variableNameArg);
+
+	elog(DEBUG1, "@<drop('%s') = true", variableName);
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * alter_value(variable_constant_name text, value anyelement) returns anyelement
+ */
+PG_FUNCTION_INFO_V1(alter_value);
+PGDLLEXPORT Datum alter_value( PG_FUNCTION_ARGS)
+{
+	char* variableName = NULL;
+	SessionVariable* variable;
+	bool found;
+	Datum newContent = (Datum) NULL;
+	Oid newValueTypeOid;
+	int newValueTypeLength;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_NARGS() != 2)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.alter_value(variable_name text, value anyelement)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	variableName = text_to_cstring((text *) PG_GETARG_TEXT_P(0));
+
+	elog(DEBUG1, "@>alter_value('%s')", variableName);
+
+	if (!strlen(variableName))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	variable = searchVariable(variableName, &variables, &found);
+	if (!found)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NO_DATA),(errmsg("Variable \"%s\" does not exists", variableName))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	newValueTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 1);
+	if (variable->type == newValueTypeOid)
+	{
+		newValueTypeLength = variable->typeLength;
+	}
+	else
+	{
+		newValueTypeLength = getTypeLength(newValueTypeOid);
+	}
+
+	if (PG_ARGISNULL(1))
+	{
+		newContent = (Datum) NULL;
+	}
+	else
+	{
+
+		if (newValueTypeLength < 0)
+		{
+			newContent = (Datum) PG_GETARG_VARLENA_P(1);
+		}
+		else
+		{
+			newContent = PG_GETARG_DATUM(1);
+		}
+
+	}
+
+	if (!setContent(variable, newValueTypeOid, PG_ARGISNULL(1), newContent))
+	{
+		/*
+		 * Something went wrong, but that has already been logged
+		 */
+		PG_RETURN_NULL()
+		;
+	}
+	variable->isModified = false;
+
+	/*
+	 * The altered value is the new initial value of a transaction scoped
+	 * variable
+	 */
+	forgetTransactionScopedValue(variable);
+
+	updateVariable(variable);
+
+	/*
+	 * Other sessions read the new value of a shared constant once the
+	 * transaction commits
+	 */
+	shareContent(variable, 0);
+
+	elog(DEBUG1, "@<alter_value('%s')", variableName);
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * Replaces the session local content of a variable.
+ *
+ * If the value is of the variable's type and that type is passed by value,
+ * the value is stored as is. Otherwise it is cast to the variable's type and
+ * copied into the variable itself or into malloced memory by coerceInput().
+ *
+ * @param SessionVariable* variable - The variable to alter
+ * @param Oid valueTypeOid - The data type of value
+ * @param bool isNull - Is the new content NULL
+ * @param Datum value - The (detoasted) new content, ignored if isNull
+ * @return bool - true if ok
+ */
+bool setContent(SessionVariable* variable, Oid valueTypeOid, bool isNull,
+		Datum value)
+{
+	Datum newContent = (Datum) NULL;
+	Datum oldContent = (Datum) NULL;
+	bool oldContentIsMalloced = false;
+	bool castFailed;
+
+	variable->modification = ++stateVersion;
+	if (variable->typeLength < 0)
+	{
+		forgetDecompressedValue(variable);
+	}
+
+	if (!isNull)
+	{
+		if (variable->type == valueTypeOid && variable->typeLength >= 0
+				&& variable->typeLength <= SIZEOF_DATUM)
+		{
+			newContent = value;
+		}
+		else
+		{
+			/*
+			 * Make sure the new content is malloced instead of palloced, and cast to the right type of course.
+			 * Inline prior content is just overwritten, malloced prior content is freed afterwards.
+			 */
+			if (DatumGetPointer(variable->content) != inlineContent(variable))
+			{
+				oldContent = variable->content;
+				oldContentIsMalloced = !variable->isNull && !variable->isShared
+						&& (variable->typeLength < 0 || variable->typeLength > SIZEOF_DATUM);
+			}
+			newContent = coerceInput(valueTypeOid, variable->type,
+					variable->typeLength, value, inlineContent(variable),
+					&castFailed);
+			if (castFailed)
+			{
+				/*
+				 * Something went wrong, but that has already been logged
+				 */
+				return false;
+			}
+			variable->content = newContent;
+			variable->isNull = false;
+			variable->isShared = false;
+			if (oldContentIsMalloced)
+			{
+				free((void*) oldContent);
+			}
+			return true;
+		}
+	}
+
+	freeContent(variable);
+
+	variable->isNull = isNull;
+	variable->content = newContent;
+	return true;
+}
+
+/*
+ * Sets the session local content of the variable named in the first argument
+ * to the value in the second argument. Shared by set(text, anyelement) and the
+ * type specific setters like set_int8(text, bigint).
+ *
+ * @param FunctionCallInfo fcinfo - The invocation of the SQL function
+ * @param Oid valueTypeOid - The data type of the second argument
+ * @param char* functionName - The name of the SQL function, for logging
+ * @return Datum - boolean true if ok
+ */
+Datum setTypedContent(FunctionCallInfo fcinfo, Oid valueTypeOid,
+		char* functionName)
+{
+	char* variableName = NULL;
+	SessionVariable* variable;
+	bool found;
+	Datum newContent = (Datum) NULL;
+	int newValueTypeLength;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable_name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	statistics.setCalls++;
+
+	variableName = text_to_cstring((text*) PG_GETARG_TEXT_P(0));
+
+	elog(DEBUG1, "@>%s('%s')", functionName, variableName);
+
+	if (!strlen(variableName))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	variable = searchVariable(variableName, &variables, &found);
+	if (!found)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NO_DATA),(errmsg("variable \"%s\" does not exists", variableName))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (!PG_ARGISNULL(1))
+	{
+		if (variable->type == valueTypeOid)
+		{
+			newValueTypeLength = variable->typeLength;
+		}
+		else
+		{
+			newValueTypeLength = getTypeLength(valueTypeOid);
+		}
+
+		if (newValueTypeLength < 0)
+		{
+			newContent = (Datum) PG_GETARG_VARLENA_P(1);
+		}
+		else
+		{
+			newContent = PG_GETARG_DATUM(1);
+		}
+	}
+
+	if (!setValue(variable, valueTypeOid, PG_ARGISNULL(1), newContent))
+	{
+		PG_RETURN_NULL()
+		;
+	}
+
+	elog(DEBUG1, "@<%s('%s')", functionName, variableName);
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * Sets the session local content of a variable, as set() does
+ *
+ * @param SessionVariable* variable - The variable to set
+ * @param Oid valueTypeOid - The data type of value
+ * @param bool isNull - The new value is null
+ * @param Datum value - The new value, detoasted if it is a varlena
+ * @return bool - false if the value could not be stored, which is logged
+ */
+bool setValue(SessionVariable* variable, Oid valueTypeOid, bool isNull,
+		Datum value)
+{
+	if (variable->isConstant && !isExecutingInitialisationFunction) // the initialisation function is allowed to alter the value of a constant
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),(errmsg("constant \"%s\" cannot be set", variable->name))));
+	}
+
+	if (!isExecutingInitialisationFunction)
+	{
+		rememberTransactionScopedValue(variable);
+	}
+	if (!setContent(variable, valueTypeOid, isNull, value))
+	{
+		return false;
+	}
+	if (!isExecutingInitialisationFunction)
+	{
+		variable->isModified = true;
+	}
+
+	if (sharedStatistics != NULL)
+	{
+		getUsage(variable)->setCalls++;
+	}
+	return true;
+}
+
+/*
+ * Remembers the value of a transaction scoped variable before the current
+ * transaction changes it first, so that transactionScopeXactCallback() can
+ * reset it when the transaction ends.
+ *
+ * @param SessionVariable* variable - The variable that is about to change
+ */
+void rememberTransactionScopedValue(SessionVariable* variable)
+{
+	TransactionScopedValue* saved;
+	Datum content;
+
+	if (!variable->isTransactionScoped)
+	{
+		return;
+	}
+	for (saved = transactionScopedValues; saved != NULL; saved = saved->next)
+	{
+		if (saved->variable == variable)
+		{
+			return;
+		}
+	}
+
+	if (!transactionScopeCallbackRegistered)
+	{
+		RegisterXactCallback(transactionScopeXactCallback, NULL);
+		transactionScopeCallbackRegistered = true;
+	}
+
+	saved = (TransactionScopedValue*) MemoryContextAlloc(TopTransactionContext,
+			sizeof(TransactionScopedValue));
+	saved->variable = variable;
+	saved->isModified = variable->isModified;
+	saved->isNull = variable->isNull;
+	saved->value = (Datum) 0;
+	if (!variable->isNull)
+	{
+		content = getContent(variable);
+		if (variable->typeLength >= 0 && variable->typeLength <= SIZEOF_DATUM)
+		{
+			saved->value = content;
+		}
+		else
+		{
+			saved->value = PointerGetDatum(
+					MemoryContextAlloc(TopTransactionContext,
+							datumGetSize(content, false, variable->typeLength)));
+			memcpy(DatumGetPointer(saved->value), DatumGetPointer(content),
+					datumGetSize(content, false, variable->typeLength));
+		}
+	}
+	saved->next = transactionScopedValues;
+	transactionScopedValues = saved;
+}
+
+/*
+ * Keeps the variable from being reset at the end of the transaction, because
+ * it is dropped or its initial value is altered
+ *
+ * @param SessionVariable* variable - The variable
+ */
+void forgetTransactionScopedValue(SessionVariable* variable)
+{
+	TransactionScopedValue** saved = &transactionScopedValues;
+
+	while (*saved != NULL)
+	{
+		if ((*saved)->variable == variable)
+		{
+			*saved = (*saved)->next;
+			return;
+		}
+		saved = &(*saved)->next;
+	}
+}
+
+/*
+ * Resets the transaction scoped variables that the transaction changed when it
+ * ends, committed or not. The remembered values are freed with the
+ * TopTransactionContext.
+ */
+void transactionScopeXactCallback(XactEvent event, void* arg)
+{
+	TransactionScopedValue* saved;
+
+	switch (event)
+	{
+	case XACT_EVENT_COMMIT:
+	case XACT_EVENT_ABORT:
+	case XACT_EVENT_PREPARE:
+		saved = transactionScopedValues;
+		transactionScopedValues = NULL;
+		for (; saved != NULL; saved = saved->next)
+		{
+			setContent(saved->variable, saved->variable->type, saved->isNull,
+					saved->value);
+			saved->variable->isModified = saved->isModified;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * set(variable_name text, value anyelement) returns boolean
+ */
+PG_FUNCTION_INFO_V1(set);
+PGDLLEXPORT Datum set( PG_FUNCTION_ARGS)
+{
+	if (PG_NARGS() != 2)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.set(variable_name text, value anyelement)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	return setTypedContent(fcinfo, get_fn_expr_argtype(fcinfo->flinfo, 1),
+			"set");
+}
+
+/*
+ * set_int4(variable_name text, value integer) returns boolean
+ */
+PG_FUNCTION_INFO_V1(set_int4);
+PGDLLEXPORT Datum set_int4( PG_FUNCTION_ARGS)
+{
+	return setTypedContent(fcinfo, INT4OID, "set_int4");
+}
+
+/*
+ * set_int8(variable_name text, value bigint) returns boolean
+ */
+PG_FUNCTION_INFO_V1(set_int8);
+PGDLLEXPORT Datum set_int8( PG_FUNCTION_ARGS)
+{
+	return setTypedContent(fcinfo, INT8OID, "set_int8");
+}
+
+/*
+ * set_bool(variable_name text, value boolean) returns boolean
+ */
+PG_FUNCTION_INFO_V1(set_bool);
+PGDLLEXPORT Datum set_bool( PG_FUNCTION_ARGS)
+{
+	return setTypedContent(fcinfo, BOOLOID, "set_bool");
+}
+
+/*
+ * set_text(variable_name text, value text) returns boolean
+ */
+PG_FUNCTION_INFO_V1(set_text);
+PGDLLEXPORT Datum set_text( PG_FUNCTION_ARGS)
+{
+	return setTypedContent(fcinfo, TEXTOID, "set_text");
+}
+
+/*
+ * set_uuid(variable_name text, value uuid) returns boolean
+ */
+PG_FUNCTION_INFO_V1(set_uuid);
+PGDLLEXPORT Datum set_uuid( PG_FUNCTION_ARGS)
+{
+	return setTypedContent(fcinfo, UUIDOID, "set_uuid");
+}
+
+/*
+ * set_timestamptz(variable_name text, value timestamp with time zone) returns boolean
+ */
+PG_FUNCTION_INFO_V1(set_timestamptz);
+PGDLLEXPORT Datum set_timestamptz( PG_FUNCTION_ARGS)
+{
+	return setTypedContent(fcinfo, TIMESTAMPTZOID, "set_timestamptz");
+}
+
+/*
+ * Returns the session local content of the variable or constant named in the
+ * first argument as resultTypeOid. Shared by get(text, anyelement) and the
+ * type specific getters like get_int8(text).
+ *
+ * @param FunctionCallInfo fcinfo - The invocation of the SQL function
+ * @param Oid resultTypeOid - The data type to return
+ * @param char* functionName - The name of the SQL function, for logging
+ * @return Datum - The content of the variable
+ */
+Datum getTypedContent(FunctionCallInfo fcinfo, Oid resultTypeOid,
+		char* functionName)
+{
+	char* variableName = NULL;
+	Datum result = (Datum) NULL;
+	SessionVariable* variable;
+	bool found;
+	bool isNull;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	statistics.getCalls++;
+
+	variableName = text_to_cstring(PG_GETARG_TEXT_P(0));
+
+	elog(DEBUG1, "@>%s('%s')", functionName, variableName);
+
+	variable = searchVariable(variableName, &variables, &found);
+	if (!found)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant '%s' does not exists", variableName ))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	result = getValue(variable, resultTypeOid, &isNull);
+	if (isNull)
+	{
+		elog(DEBUG1, "@<%s('%s') = NULL", functionName, variableName);
+		PG_RETURN_NULL()
+		;
+	}
+
+	elog(DEBUG1, "@<%s('%s')", functionName, variableName);
+
+	PG_RETURN_DATUM(result);
+}
+
+/*
+ * Returns the session local content of the variable or constant as
+ * resultTypeOid, as get() does.
+ *
+ * If the variable is of the requested type and that type is passed by value,
+ * the stored Datum is returned as is. Otherwise coerceOutput() copies and, if
+ * necessary, casts the content.
+ *
+ * @param SessionVariable* variable - The variable or constant to read
+ * @param Oid resultTypeOid - The data type to return
+ * @param bool* isNull - Is set to true if the content is null
+ * @return Datum - The content of the variable
+ */
+Datum getValue(SessionVariable* variable, Oid resultTypeOid, bool* isNull)
+{
+	Datum result;
+	bool castFailed;
+	CoercionPathType coercionPathType;
+	Oid coercionFunctionOid;
+
+	*isNull = variable->isNull;
+	if (variable->isNull)
+	{
+		if (resultTypeOid == variable->type)
+		{
+			coercionPathType = COERCION_PATH_RELABELTYPE;
+		}
+		else
+		{
+			coercionPathType = find_coercion_pathway(variable->type,
+					resultTypeOid, COERCION_EXPLICIT, &coercionFunctionOid);
+		}
+		switch (coercionPathType)
+		{
+		case COERCION_PATH_RELABELTYPE:
+		case COERCION_PATH_FUNC:
+		case COERCION_PATH_COERCEVIAIO:
+			countGet(variable, COERCION_PATH_NONE, resultTypeOid, true,
+					(Datum) NULL);
+			return (Datum) NULL;
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("The variable's internal type %s, cannot be cast to type %s", getTypeName(variable->type) ,getTypeName(resultTypeOid) ))));
+		}
+	}
+
+	if (resultTypeOid == variable->type && variable->typeLength >= 0
+			&& variable->typeLength <= SIZEOF_DATUM && !variable->isShared)
+	{
+		countGet(variable, COERCION_PATH_RELABELTYPE, resultTypeOid, false,
+				variable->content);
+		return variable->content;
+	}
+
+	if (resultTypeOid != variable->type && !variable->isShared)
+	{
+		result = getCoercedValue(variable, resultTypeOid, &coercionPathType);
+	}
+	else
+	{
+		result = coerceOutput(variable->type, variable->typeLength,
+				getContent(variable), resultTypeOid, &castFailed,
+				&coercionPathType);
+	}
+	countGet(variable, coercionPathType, resultTypeOid, false, result);
+
+	return result;
+}
+
+/*
+ * Returns the content of the variable cast to resultTypeOid. The result of an
+ * immutable cast function or of a conversion via text by immutable output and
+ * input functions is kept until the variable changes, so reading a variable
+ * repeatedly as another type converts it once. All kept values are forgotten
+ * when a setting that conversions depend on changes, see
+ * coercionSettingsChanged().
+ *
+ * @param SessionVariable* variable - The variable, not null and not shared
+ * @param Oid resultTypeOid - The data type to return, not the variable's type
+ * @param CoercionPathType* coercionPath - Is set to the kind of cast
+ * @return Datum - The cast content, palloced if passed by reference
+ */
+Datum getCoercedValue(SessionVariable* variable, Oid resultTypeOid,
+		CoercionPathType* coercionPath)
+{
+	CoercedValue* entry = &coercedValues[((((uintptr_t) variable) >> 4)
+			^ resultTypeOid) % COERCION_CACHE_SIZE];
+	MemoryContext oldContext;
+	Datum result;
+	Datum cachedValue;
+	bool castFailed;
+	int16 typeLength;
+	bool typeByValue;
+
+	if (coercionSettingsChanged())
+	{
+		forgetCoercedValues();
+	}
+
+	if (entry->variable == variable && entry->type == resultTypeOid
+			&& entry->modification == variableVersion(variable))
+	{
+		statistics.coercionCacheHits++;
+		*coercionPath = entry->coercionPath;
+		return datumCopy(entry->value, entry->typeByValue, entry->typeLength);
+	}
+
+	result = coerceOutput(variable->type, variable->typeLength,
+			getContent(variable), resultTypeOid, &castFailed, coercionPath);
+	if (!isImmutableCoercion(variable->type, resultTypeOid, *coercionPath))
+	{
+		/*
+		 * Just a copy, or a result that may depend on the catalog or on the
+		 * search_path
+		 */
+		return result;
+	}
+
+	if (coercionContext == NULL)
+	{
+		coercionContext = AllocSetContextCreate(TopMemoryContext,
+				"session_variable coerced values", ALLOCSET_DEFAULT_SIZES);
+	}
+	get_typlenbyval(resultTypeOid, &typeLength, &typeByValue);
+	oldContext = MemoryContextSwitchTo(coercionContext);
+	cachedValue = datumCopy(result, typeByValue, typeLength);
+	MemoryContextSwitchTo(oldContext);
+
+	if (entry->variable != NULL && !entry->typeByValue)
+	{
+		pfree(DatumGetPointer(entry->value));
+	}
+	entry->variable = variable;
+	entry->modification = variableVersion(variable);
+	entry->type = resultTypeOid;
+	entry->typeLength = typeLength;
+	entry->typeByValue = typeByValue;
+	entry->coercionPath = *coercionPath;
+	entry->value = cachedValue;
+
+	return result;
+}
+
+/*
+ * Checks if a cast can be kept, because it is done by an immutable cast
+ * function or via text by immutable output and input functions
+ *
+ * @param Oid sourceType - The type of the variable
+ * @param Oid targetType - The type it is cast to
+ * @param CoercionPathType coercionPath - The kind of cast, see coerceOutput()
+ * @return bool - true if the result only depends on the value
+ */
+bool isImmutableCoercion(Oid sourceType, Oid targetType,
+		CoercionPathType coercionPath)
+{
+	Oid functionOid;
+	Oid inputFunctionOid;
+	Oid inputFunctionParam;
+	bool typeIsVarlena;
+
+	switch (coercionPath)
+	{
+	case COERCION_PATH_FUNC:
+		find_coercion_pathway(targetType, sourceType, COERCION_EXPLICIT,
+				&functionOid);
+		return func_volatile(functionOid) == PROVOLATILE_IMMUTABLE;
+	case COERCION_PATH_COERCEVIAIO:
+		getTypeOutputInfo(sourceType, &functionOid, &typeIsVarlena);
+		getTypeInputInfo(targetType, &inputFunctionOid, &inputFunctionParam);
+		return func_volatile(functionOid) == PROVOLATILE_IMMUTABLE
+				&& func_volatile(inputFunctionOid) == PROVOLATILE_IMMUTABLE;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Checks if a setting that the output, input or cast functions of types depend
+ * on has changed since the previous check, like DateStyle for a date that is
+ * read as text or TimeZone for a timestamptz that is read as date
+ *
+ * @return bool - true if a setting has changed
+ */
+bool coercionSettingsChanged(void)
+{
+	CoercionSettings* current = &coercionSettings;
+
+	if (current->lcNumeric != NULL && current->dateStyle == DateStyle
+			&& current->dateOrder == DateOrder
+			&& current->intervalStyle == IntervalStyle
+			&& current->extraFloatDigits == extra_float_digits
+			&& current->byteaOutput == bytea_output
+			&& current->timeZone == session_timezone
+			&& strcmp(current->lcNumeric, locale_numeric) == 0
+			&& strcmp(current->lcMonetary, locale_monetary) == 0)
+	{
+		return false;
+	}
+
+	current->dateStyle = DateStyle;
+	current->dateOrder = DateOrder;
+	current->intervalStyle = IntervalStyle;
+	current->extraFloatDigits = extra_float_digits;
+	current->byteaOutput = bytea_output;
+	current->timeZone = session_timezone;
+	if (current->lcNumeric != NULL)
+	{
+		pfree(current->lcNumeric);
+		pfree(current->lcMonetary);
+	}
+	current->lcNumeric = MemoryContextStrdup(TopMemoryContext, locale_numeric);
+	current->lcMonetary = MemoryContextStrdup(TopMemoryContext,
+			locale_monetary);
+	return true;
+}
+
+/*
+ * Empties the cache of getCoercedValue(), before the variables are freed
+ */
+void forgetCoercedValues(void)
+{
+	memset(coercedValues, 0, sizeof(coercedValues));
+	if (coercionContext != NULL)
+	{
+		MemoryContextReset(coercionContext);
+	}
+}
+
+/*
+ * get(variable_constant_name text) returns anyelement
+ */
+PG_FUNCTION_INFO_V1(get);
+PGDLLEXPORT Datum get( PG_FUNCTION_ARGS)
+{
+	if (PG_NARGS() != 2)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.get(variable_or_constant_name text, just_for_type anyelement)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	return getTypedContent(fcinfo, get_fn_expr_argtype(fcinfo->flinfo, 1),
+			"get");
+}
+
+/*
+ * get_int4(variable_constant_name text) returns integer
+ */
+PG_FUNCTION_INFO_V1(get_int4);
+PGDLLEXPORT Datum get_int4( PG_FUNCTION_ARGS)
+{
+	return getTypedContent(fcinfo, INT4OID, "get_int4");
+}
+
+/*
+ * get_int8(variable_constant_name text) returns bigint
+ */
+PG_FUNCTION_INFO_V1(get_int8);
+PGDLLEXPORT Datum get_int8( PG_FUNCTION_ARGS)
+{
+	return getTypedContent(fcinfo, INT8OID, "get_int8");
+}
+
+/*
+ * get_bool(variable_constant_name text) returns boolean
+ */
+PG_FUNCTION_INFO_V1(get_bool);
+PGDLLEXPORT Datum get_bool( PG_FUNCTION_ARGS)
+{
+	return getTypedContent(fcinfo, BOOLOID, "get_bool");
+}
+
+/*
+ * get_text(variable_constant_name text) returns text
+ */
+PG_FUNCTION_INFO_V1(get_text);
+PGDLLEXPORT Datum get_text( PG_FUNCTION_ARGS)
+{
+	return getTypedContent(fcinfo, TEXTOID, "get_text");
+}
+
+/*
+ * get_uuid(variable_constant_name text) returns uuid
+ */
+PG_FUNCTION_INFO_V1(get_uuid);
+PGDLLEXPORT Datum get_uuid( PG_FUNCTION_ARGS)
+{
+	return getTypedContent(fcinfo, UUIDOID, "get_uuid");
+}
+
+/*
+ * get_timestamptz(variable_constant_name text) returns timestamp with time zone
+ */
+PG_FUNCTION_INFO_V1(get_timestamptz);
+PGDLLEXPORT Datum get_timestamptz( PG_FUNCTION_ARGS)
+{
+	return getTypedContent(fcinfo, TIMESTAMPTZOID, "get_timestamptz");
+}
+
+/*
+ * Finds the variable of a handle of the C interface, again if variables have
+ * been freed since it was found last
+ *
+ * @param SessionVariableHandle* handle - As returned by apiLookup()
+ * @return SessionVariable* - The variable or NULL if it does not exist
+ */
+SessionVariable* resolveHandle(SessionVariableHandle* handle)
+{
+	bool found;
+
+	if (virgin)
+	{
+		reload();
+	}
+	if (boundSettingsChanged)
+	{
+		applyBoundSettings();
+	}
+
+	if (handle->variable == NULL || handle->generation != handleGeneration)
+	{
+		handle->variable = searchVariable(handle->name, &variables, &found);
+		if (!found)
+		{
+			handle->variable = NULL;
+		}
+		handle->generation = handleGeneration;
+	}
+	return (SessionVariable*) handle->variable;
+}
+
+/*
+ * SessionVariableApi.lookup, see session_variable_api.h
+ */
+SessionVariableHandle* apiLookup(const char* variableName)
+{
+	SessionVariableHandle* handle;
+	int nameLength = strlen(variableName);
+
+	handle = palloc(offsetof(SessionVariableHandle, name) + nameLength + 1);
+	memcpy(handle->name, variableName, nameLength + 1);
+	handle->variable = NULL;
+	handle->generation = 0;
+
+	if (resolveHandle(handle) == NULL)
+	{
+		pfree(handle);
+		return NULL;
+	}
+	return handle;
+}
+
+/*
+ * SessionVariableApi.get, see session_variable_api.h
+ */
+bool apiGet(SessionVariableHandle* handle, Oid resultType, Datum* value,
+		bool* isNull)
+{
+	SessionVariable* variable = resolveHandle(handle);
+
+	statistics.getCalls++;
+	if (variable == NULL)
+	{
+		return false;
+	}
+	*value = getValue(variable, resultType, isNull);
+	return true;
+}
+
+/*
+ * SessionVariableApi.getByName, see session_variable_api.h
+ */
+bool apiGetByName(const char* variableName, Oid resultType, Datum* value,
+		bool* isNull)
+{
+	SessionVariable* variable;
+	bool found;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	statistics.getCalls++;
+	variable = searchVariable((char*) variableName, &variables, &found);
+	if (!found)
+	{
+		return false;
+	}
+	*value = getValue(variable, resultType, isNull);
+	return true;
+}
+
+/*
+ * SessionVariableApi.set, see session_variable_api.h
+ */
+bool apiSet(SessionVariableHandle* handle, Oid valueType, Datum value,
+		bool isNull)
+{
+	SessionVariable* variable = resolveHandle(handle);
+
+	statistics.setCalls++;
+	if (variable == NULL)
+	{
+		return false;
+	}
+	if (!isNull && (valueType == variable->type ?
+			variable->typeLength : getTypeLength(valueType)) < 0)
+	{
+		value = PointerGetDatum(PG_DETOAST_DATUM(value));
+	}
+	return setValue(variable, valueType, isNull, value);
+}
+
+/*
+ * SessionVariableApi.setByName, see session_variable_api.h
+ */
+bool apiSetByName(const char* variableName, Oid valueType, Datum value,
+		bool isNull)
+{
+	SessionVariable* variable;
+	bool found;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	statistics.setCalls++;
+	variable = searchVariable((char*) variableName, &variables, &found);
+	if (!found)
+	{
+		return false;
+	}
+	if (!isNull && (valueType == variable->type ?
+			variable->typeLength : getTypeLength(valueType)) < 0)
+	{
+		value = PointerGetDatum(PG_DETOAST_DATUM(value));
+	}
+	return setValue(variable, valueType, isNull, value);
+}
+
+/*
+ * SessionVariableApi.changeGeneration, see session_variable_api.h
+ */
+uint64 apiChangeGeneration(void)
+{
+	return stateVersion;
+}
+
+/*
+ * SessionVariableApi.getVersion, see session_variable_api.h
+ */
+bool apiGetVersion(SessionVariableHandle* handle, uint64* version)
+{
+	SessionVariable* variable = resolveHandle(handle);
+
+	if (variable == NULL)
+	{
+		return false;
+	}
+	*version = variableVersion(variable);
+	return true;
+}
+
+/*
+ * Replaces an invocation of session_variable.get_stable(text, anyelement) by
+ * an uncorrelated scalar subquery that invokes session_variable.get(text,
+ * anyelement) with the same arguments. The planner turns that subquery into an
+ * initplan, so the variable is looked up only once per execution and the
+ * result is available as a Param, which can be used in index quals and for
+ * run-time partition pruning.
+ *
+ * Only invocations with constant arguments in a query with a FROM clause are
+ * replaced. Otherwise there is nothing to gain and a query without FROM
+ * clause, as PL/pgSQL uses for simple expressions, would lose its fast path.
+ *
+ * @param PlannerInfo* root - The planner info of the query being planned
+ * @param FuncExpr* getStableCall - The get_stable() invocation
+ * @return Node* - The replacing SubLink or NULL if the invocation is to be kept
+ */
+Node* replaceByInitPlan(PlannerInfo* root, FuncExpr* getStableCall)
+{
+	Oid argTypes[2] =
+	{ TEXTOID, ANYELEMENTOID };
+	Oid getFunctionOid;
+	FuncExpr* getCall;
+	Query* subQuery;
+	SubLink* subLink;
+	ListCell* arg;
+
+	if (root == NULL || root->parse == NULL
+			|| root->parse->commandType == CMD_UTILITY
+			|| root->parse->jointree == NULL
+			|| root->parse->jointree->fromlist == NIL)
+	{
+		return NULL;
+	}
+
+	foreach(arg, getStableCall->args)
+	{
+		if (!IsA(lfirst(arg), Const))
+		{
+			return NULL;
+		}
+	}
+
+	getFunctionOid = LookupFuncName(
+			list_make2(makeString("session_variable"), makeString("get")), 2,
+			argTypes, true);
+	if (!OidIsValid(getFunctionOid))
+	{
+		return NULL;
+	}
+
+	getCall = makeFuncExpr(getFunctionOid, getStableCall->funcresulttype,
+			copyObject(getStableCall->args), getStableCall->funccollid,
+			getStableCall->inputcollid, COERCE_EXPLICIT_CALL);
+	getCall->location = getStableCall->location;
+
+	subQuery = makeNode(Query);
+	subQuery->commandType = CMD_SELECT;
+	subQuery->querySource = QSRC_ORIGINAL;
+	subQuery->canSetTag = true;
+	subQuery->jointree = makeFromExpr(NIL, NULL);
+	subQuery->targetList = list_make1(
+			makeTargetEntry((Expr*) getCall, 1, pstrdup("get_stable"), false));
+
+	subLink = makeNode(SubLink);
+	subLink->subLinkType = EXPR_SUBLINK;
+	subLink->subLinkId = 0;
+	subLink->testexpr = NULL;
+	subLink->operName = NIL;
+	subLink->subselect = (Node*) subQuery;
+	subLink->location = getStableCall->location;
+
+	/*
+	 * Make sure the planner processes the sublink we just introduced.
+	 */
+	root->parse->hasSubLinks = true;
+
+	elog(DEBUG2, "get_stable() invocation replaced by an initplan");
+
+	return (Node*) subLink;
+}
+
+/*
+ * get_stable_support(internal) returns internal
+ *
+ * Planner support function for session_variable.get_stable(text, anyelement).
+ * A SupportRequestSimplify replaces the invocation by an initplan (see
+ * replaceByInitPlan()), a SupportRequestCost reports the cost of a b-tree
+ * lookup.
+ */
+PG_FUNCTION_INFO_V1(get_stable_support);
+PGDLLEXPORT Datum get_stable_support( PG_FUNCTION_ARGS)
+{
+	Node* rawRequest = (Node*) PG_GETARG_POINTER(0);
+	Node* result = NULL;
+
+	if (IsA(rawRequest, SupportRequestSimplify))
+	{
+		SupportRequestSimplify* request = (SupportRequestSimplify*) rawRequest;
+
+		result = replaceByInitPlan(request->root, request->fcall);
+	}
+	else if (IsA(rawRequest, SupportRequestCost))
+	{
+		SupportRequestCost* request = (SupportRequestCost*) rawRequest;
+
+		request->startup = 0;
+		request->per_tuple = 2 * cpu_operator_cost;
+		result = (Node*) request;
+	}
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * get_constant(constant_name text) returns anyelement
+ */
+PG_FUNCTION_INFO_V1(get_constant);
+PGDLLEXPORT Datum get_constant( PG_FUNCTION_ARGS)
+{
+	char* variableName = NULL;
+	Datum result = (Datum) NULL;
+	SessionVariable* variable;
+	bool found;
+	Oid resultTypeOid;
+	bool castFailed;
+	CoercionPathType coercionPathType;
+	Oid coercionFunctionOid;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_NARGS() != 2)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.get_constant(constant_name text, just_for_type anyelement)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	statistics.getCalls++;
+
+	variableName = text_to_cstring(PG_GETARG_TEXT_P(0));
+
+	elog(DEBUG1, "@>get_constant('%s')", variableName);
+
+	variable = searchVariable(variableName, &variables, &found);
+	if (!found)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NO_DATA),(errmsg("constant '%s' does not exists", variableName ))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (!variable->isConstant)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),(errmsg("'%s' is not a constant", variableName ))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	resultTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 1);
+	if (variable->isNull)
+	{
+		if (resultTypeOid == variable->type)
+		{
+			coercionPathType = COERCION_PATH_RELABELTYPE;
+		}
+		else
+		{
+			coercionPathType = find_coercion_pathway(variable->type,
+					resultTypeOid, COERCION_EXPLICIT, &coercionFunctionOid);
+		}
+		switch (coercionPathType)
+		{
+		case COERCION_PATH_RELABELTYPE:
+		case COERCION_PATH_FUNC:
+		case COERCION_PATH_COERCEVIAIO:
+			countGet(variable, COERCION_PATH_NONE, resultTypeOid, true,
+					(Datum) NULL);
+			elog(DEBUG1, "@<get('%s') = NULL", variableName);
+			PG_RETURN_NULL()
+			;
+			break;
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("The constant's internal type %s, cannot be cast to type %s", getTypeName(variable->type) ,getTypeName(resultTypeOid) ))));
+			PG_RETURN_NULL()
+			;
+		}
+	}
+
+	result = coerceOutput(variable->type, variable->typeLength,
+			getContent(variable), resultTypeOid, &castFailed, &coercionPathType);
+	countGet(variable, coercionPathType, resultTypeOid, false, result);
+
+	elog(DEBUG1, "@<get_constant('%s')", variableName);
+
+	PG_RETURN_DATUM(result);
+}
+
+/*
+ * type_of(variable_or_constant_name text) returns regtype
+ */
+PG_FUNCTION_INFO_V1(type_of);
+PGDLLEXPORT Datum type_of( PG_FUNCTION_ARGS)
+{
+	char* variableName = NULL;
+	SessionVariable* variable;
+	bool found;
 
-	if (parentLevel == NULL)
+	if (virgin)
 	{
-		variables = variable;
+		reload();
+	}
+
+	if (PG_NARGS() != 1)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.type_of(variable_or_constant_name text)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	variableName = text_to_cstring(PG_GETARG_TEXT_P(0));
+
+	elog(DEBUG1, "@>type_of('%s')", variableName);
+
+	variable = searchVariable(variableName, &variables, &found);
+	if (!found)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant '%s' does not exists", variableName ))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	elog(DEBUG1, "@<type_of('%s')", variableName);
+
+	PG_RETURN_OID(variable->type);
+}
+
+/*
+ * version(variable_or_constant_name text) returns bigint
+ *
+ * Returns the version of the variable or constant, see variableVersion(). It
+ * is higher after every set(), alter_value() or reload, so a value need only
+ * be read again if its version differs from the one it was read at.
+ */
+PG_FUNCTION_INFO_V1(version);
+PGDLLEXPORT Datum version( PG_FUNCTION_ARGS)
+{
+	char* variableName = NULL;
+	SessionVariable* variable;
+	bool found;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_NARGS() != 1)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.version(variable_or_constant_name text)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	variableName = text_to_cstring(PG_GETARG_TEXT_P(0));
+
+	elog(DEBUG1, "@>version('%s')", variableName);
+
+	variable = searchVariable(variableName, &variables, &found);
+	if (!found)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant '%s' does not exists", variableName ))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	elog(DEBUG1, "@<version('%s')", variableName);
+
+	PG_RETURN_INT64((int64) variableVersion(variable));
+}
+
+/*
+ * exists(variable_constant_name text) returns bool
+ */
+PG_FUNCTION_INFO_V1(exists);
+PGDLLEXPORT Datum exists( PG_FUNCTION_ARGS)
+{
+	bool found;
+	char* variableName;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_NARGS() != 1)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.exists(variable_or_constant_name text)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	statistics.existsCalls++;
+
+	variableName = text_to_cstring((text*) PG_GETARG_TEXT_P(0));
+
+	elog(DEBUG1, "@>exists('%s')", variableName);
+
+	searchVariable(variableName, &variables, &found);
+
+	elog(DEBUG1, "@<exists('%s') = %d", variableName, found);
+
+	PG_RETURN_BOOL(found);
+}
+
+/*
+ * is_constant(variable_constant_name text) returns bool
+ */
+PG_FUNCTION_INFO_V1(is_constant);
+PGDLLEXPORT Datum is_constant( PG_FUNCTION_ARGS)
+{
+	char* variableName;
+	SessionVariable* variable;
+	bool found;
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	if (PG_NARGS() != 1)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.exists(variable_or_constant_name text)"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	variableName = text_to_cstring((text*) PG_GETARG_TEXT_P(0));
+
+	elog(DEBUG1, "@>is_constant('%s')", variableName);
+
+	variable = searchVariable(variableName, &variables, &found);
+	if (!found)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant '%s' does not exists", variableName ))));
+		PG_RETURN_NULL()
+		;
+	}
+
+	elog(DEBUG1, "@<is_constant('%s') = %d", variableName,
+	variable->isConstant);
+
+	PG_RETURN_BOOL(variable->isConstant);
+}
+
+/*
+ * init() returns integer
+ */
+PG_FUNCTION_INFO_V1(init);
+PGDLLEXPORT Datum init( PG_FUNCTION_ARGS)
+{
+	int result;
+
+	if (PG_NARGS() != 0)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.init()"))));
+		PG_RETURN_INT32(-1);
+	}
+
+	elog(DEBUG1, "@>init()");
+
+	forgetRowSets();
+	result = reload();
+
+	elog(DEBUG1, "@<init() = %d", result);
+
+	PG_RETURN_INT32(result);
+}
+
+/*
+ * function session_variable.init_worker() returns void
+ *
+ * Prepares a background worker that is connected to a database for the use of
+ * variables and constants. The variables are (re)loaded from the
+ * session_variable.variables table when they are used next, so a long running
+ * worker can invoke init_worker() at the start of each job to see the catalog
+ * as it is then. In a normal session this is a lazy init().
+ */
+PG_FUNCTION_INFO_V1(init_worker);
+PGDLLEXPORT Datum init_worker( PG_FUNCTION_ARGS)
+{
+	elog(DEBUG1, "@>init_worker()");
+
+	if (!OidIsValid(MyDatabaseId))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE), (errmsg("session_variable can only be used in a process that is connected to a database"))));
+	}
+	checkInstalledVersion();
+
+	flushStatistics();
+	virgin = true;
+
+	elog(DEBUG1, "@<init_worker()");
+	PG_RETURN_VOID();
+}
+
+/*
+ * function session_variable.current_values(include_text boolean) returns setof record
+ *
+ * Returns the variables and constants of the current session in name order
+ * with their current values. The values are only converted to text if
+ * include_text is true.
+ */
+PG_FUNCTION_INFO_V1(current_values);
+PGDLLEXPORT Datum current_values( PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo* rsinfo = (ReturnSetInfo*) fcinfo->resultinfo;
+	TupleDesc tupleDesc;
+	Tuplestorestate* tupleStore;
+	MemoryContext oldContext;
+	bool includeText = PG_ARGISNULL(0) || PG_GETARG_BOOL(0);
+
+	if (virgin)
+	{
+		reload();
+	}
+	if (boundSettingsChanged)
+	{
+		applyBoundSettings();
+	}
+
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo)
+			|| !(rsinfo->allowedModes & SFRM_Materialize))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), (errmsg("set-valued function called in context that cannot accept a set"))));
+	}
+	if (get_call_result_type(fcinfo, NULL, &tupleDesc) != TYPEFUNC_COMPOSITE)
+	{
+		elog(ERROR, "return type must be a row type");
+	}
+
+	oldContext = MemoryContextSwitchTo(
+			rsinfo->econtext->ecxt_per_query_memory);
+	tupleStore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupleStore;
+	rsinfo->setDesc = tupleDesc;
+	MemoryContextSwitchTo(oldContext);
+
+	putCurrentValues(variables, includeText, tupleStore, tupleDesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * Adds a row for the variable and its subordinates in name order to the
+ * result of current_values()
+ *
+ * @param SessionVariable* variable - The (sub)tree to add, may be NULL
+ * @param bool includeText - Fill the value_text column
+ * @param Tuplestorestate* tupleStore - Receives the rows
+ * @param TupleDesc tupleDesc - The result type of current_values()
+ */
+void putCurrentValues(SessionVariable* variable, bool includeText,
+		Tuplestorestate* tupleStore, TupleDesc tupleDesc)
+{
+	Datum values[6];
+	bool nulls[6];
+	Datum content;
+	Oid outputFunctionOid;
+	bool typeIsVarlena;
+
+	if (variable == NULL)
+	{
+		return;
+	}
+
+	putCurrentValues(variable->prior, includeText, tupleStore, tupleDesc);
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = CStringGetTextDatum(variable->name);
+	values[1] = ObjectIdGetDatum(variable->type);
+	values[2] = BoolGetDatum(variable->isConstant);
+	values[3] = BoolGetDatum(variable->isModified);
+	if (variable->isNull)
+	{
+		nulls[4] = true;
+		nulls[5] = true;
 	}
 	else
 	{
-		int diff = strcmp(varName, parentLevel->name);
+		/*
+		 * The size is the size in memory, so of the compressed value if the
+		 * value is kept compressed
+		 */
+		content = variable->isShared ?
+				readSharedConstant(variable) : variable->content;
+		if (variable->typeLength < 0)
+		{
+			values[5] = Int32GetDatum(VARSIZE(content));
+		}
+		else
+		{
+			values[5] = Int32GetDatum(variable->typeLength);
+		}
 
-		if (diff < 0)
+		if (includeText)
 		{
-			parentLevel->prior = variable;
+			getTypeOutputInfo(variable->type, &outputFunctionOid,
+					&typeIsVarlena);
+			values[4] = CStringGetTextDatum(
+					OidOutputFunctionCall(outputFunctionOid,
+							variable->isShared ? content : getContent(variable)));
 		}
 		else
 		{
-			parentLevel->next = variable;
+			nulls[4] = true;
 		}
 	}
+	tuplestore_putvalues(tupleStore, tupleDesc, values, nulls);
 
-	return insertVariable(variable);
+	putCurrentValues(variable->next, includeText, tupleStore, tupleDesc);
 }
 
 /*
- * create_variable(variable_name text, variable_type regtype) returns boolean
- * create_variable(variable_name text, variable_type regtype, initial_value anyelement) returns boolean
+ * function session_variable.changes_since(since_sequence bigint) returns setof record
+ *
+ * Returns the variables and constants of the current session in name order
+ * that have been created, loaded or changed after since_sequence,
+ * with their current values. The highest modification_sequence in the
+ * result is the point from which to ask for the next changes.
  */
-PG_FUNCTION_INFO_V1(create_variable);
-PGDLLEXPORT Datum create_variable( PG_FUNCTION_ARGS)
+PG_FUNCTION_INFO_V1(changes_since);
+PGDLLEXPORT Datum changes_since( PG_FUNCTION_ARGS)
 {
-	text* variableName = NULL;
-	Oid type = InvalidOid;
-	Oid typeOid = InvalidOid;
-	Datum content = (Datum) NULL;
-	Oid contentTypeOid;
-	int typeLength;
-	bool isNull = false;
-	bool result;
-	int contentTypeLength;
-	bool castFailed;
-	char* variableNameStr;
+	ReturnSetInfo* rsinfo = (ReturnSetInfo*) fcinfo->resultinfo;
+	TupleDesc tupleDesc;
+	Tuplestorestate* tupleStore;
+	MemoryContext oldContext;
+	int64 sinceModification = PG_ARGISNULL(0) ? 0 : PG_GETARG_INT64(0);
 
 	if (virgin)
 	{
 		reload();
 	}
+	if (boundSettingsChanged)
+	{
+		applyBoundSettings();
+	}
 
-	if (PG_NARGS() < 2 || PG_NARGS() > 3)
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo)
+			|| !(rsinfo->allowedModes & SFRM_Materialize))
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.create_variable(variable_name text, variable_type regtype) " "or session_variable.create_variable(variable_name text, variable_type regtype, initial_value anyelement)"))));
-		PG_RETURN_BOOL(false);
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), (errmsg("set-valued function called in context that cannot accept a set"))));
+	}
+	if (get_call_result_type(fcinfo, NULL, &tupleDesc) != TYPEFUNC_COMPOSITE)
+	{
+		elog(ERROR, "return type must be a row type");
 	}
 
-	if (PG_ARGISNULL(0))
+	oldContext = MemoryContextSwitchTo(
+			rsinfo->econtext->ecxt_per_query_memory);
+	tupleStore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupleStore;
+	rsinfo->setDesc = tupleDesc;
+	MemoryContextSwitchTo(oldContext);
+
+	putChanges(variables, (uint64) Max(sinceModification, 0), tupleStore,
+			tupleDesc);
+
+	return (Datum) 0;
+}
+
+/*
+ * Adds a row for the variable and its subordinates in name order to the
+ * result of changes_since() if they have changed after sinceModification
+ *
+ * @param SessionVariable* variable - The (sub)tree to add, may be NULL
+ * @param uint64 sinceModification - The state version of the last sync
+ * @param Tuplestorestate* tupleStore - Receives the rows
+ * @param TupleDesc tupleDesc - The result type of changes_since()
+ */
+void putChanges(SessionVariable* variable, uint64 sinceModification,
+		Tuplestorestate* tupleStore, TupleDesc tupleDesc)
+{
+	Datum values[5];
+	bool nulls[5];
+	Oid outputFunctionOid;
+	bool typeIsVarlena;
+
+	if (variable == NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable name must be filled"))));
-		PG_RETURN_BOOL(false);
+		return;
 	}
-	variableName = PG_GETARG_TEXT_P(0);
 
-	if (PG_ARGISNULL(1))
+	putChanges(variable->prior, sinceModification, tupleStore, tupleDesc);
+
+	if (variable->modification > sinceModification)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable type must be filled"))));
-		PG_RETURN_BOOL(false);
+		memset(nulls, 0, sizeof(nulls));
+		values[0] = CStringGetTextDatum(variable->name);
+		values[1] = ObjectIdGetDatum(variable->type);
+		values[2] = BoolGetDatum(variable->isConstant);
+		if (variable->isNull)
+		{
+			nulls[3] = true;
+		}
+		else
+		{
+			getTypeOutputInfo(variable->type, &outputFunctionOid,
+					&typeIsVarlena);
+			values[3] = CStringGetTextDatum(
+					OidOutputFunctionCall(outputFunctionOid,
+							getContent(variable)));
+		}
+		values[4] = Int64GetDatum((int64) variable->modification);
+		tuplestore_putvalues(tupleStore, tupleDesc, values, nulls);
 	}
-	type = PG_GETARG_OID(1);
-	typeOid = DatumGetObjectId(type);
-	if (!checkTypeType(typeOid))
+
+	putChanges(variable->next, sinceModification, tupleStore, tupleDesc);
+}
+
+/*
+ * function session_variable.export_state() returns bytea
+ *
+ * Returns the values of all variables of the current session in the binary
+ * format of their types, so they can be recreated in another session of the
+ * same database with import_state(). Constants are not included, they are
+ * the same in every session.
+ */
+PG_FUNCTION_INFO_V1(export_state);
+PGDLLEXPORT Datum export_state( PG_FUNCTION_ARGS)
+{
+	StringInfoData buffer;
+
+	if (virgin)
 	{
-		PG_RETURN_BOOL(false);
+		reload();
+	}
+	if (boundSettingsChanged)
+	{
+		applyBoundSettings();
 	}
-	typeLength = getTypeLength(typeOid);
 
-	variableNameStr = text_to_cstring(variableName);
-	elog(DEBUG1, "@>create_variable('%s')", variableNameStr);
-	if (!strlen(variableNameStr))
+	elog(DEBUG1, "@>export_state()");
+
+	pq_begintypsend(&buffer);
+	pq_sendint32(&buffer, EXPORTED_STATE_FORMAT);
+	pq_sendint32(&buffer, MyDatabaseId);
+	exportVariables(variables, &buffer);
+	pq_sendint32(&buffer, 0);
+
+	elog(DEBUG1, "@<export_state()");
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buffer));
+}
+
+/*
+ * Adds the variable and its subordinates in name order to the result of
+ * export_state()
+ *
+ * @param SessionVariable* variable - The (sub)tree to export, may be NULL
+ * @param StringInfo buffer - Receives the exported variables
+ */
+void exportVariables(SessionVariable* variable, StringInfo buffer)
+{
+	Oid sendFunctionOid;
+	bool typeIsVarlena;
+	bytea* value;
+
+	if (variable == NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable name must be filled"))));
-		PG_RETURN_NULL()
-		;
+		return;
 	}
 
-	isNull = PG_NARGS() < 3 || PG_ARGISNULL(2);
-	if (!isNull)
+	exportVariables(variable->prior, buffer);
+
+	if (!variable->isConstant)
 	{
-		contentTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 2);
-		if (typeOid == contentTypeOid)
+		pq_sendint32(buffer, variable->nameLength);
+		pq_sendbytes(buffer, variable->name, variable->nameLength);
+		pq_sendint32(buffer, variable->type);
+		pq_sendbyte(buffer, variable->isModified);
+		if (variable->isNull)
 		{
-			contentTypeLength = typeLength;
+			pq_sendint32(buffer, -1);
 		}
 		else
 		{
-			contentTypeLength = getTypeLength(contentTypeOid);
+			getTypeBinaryOutputInfo(variable->type, &sendFunctionOid,
+					&typeIsVarlena);
+			value = OidSendFunctionCall(sendFunctionOid, getContent(variable));
+			pq_sendint32(buffer, VARSIZE(value) - VARHDRSZ);
+			pq_sendbytes(buffer, VARDATA(value), VARSIZE(value) - VARHDRSZ);
+			pfree(value);
 		}
-		if (contentTypeLength < 0)
+	}
+
+	exportVariables(variable->next, buffer);
+}
+
+/*
+ * function session_variable.import_state(state bytea) returns integer
+ *
+ * Sets the variables to the values in state as returned by export_state().
+ * All values are checked before the first one is set, so either all or none
+ * of the variables get their exported value.
+ */
+PG_FUNCTION_INFO_V1(import_state);
+PGDLLEXPORT Datum import_state( PG_FUNCTION_ARGS)
+{
+	bytea* state;
+	StringInfoData buffer;
+	StringInfoData valueBuffer;
+	ExportedValue* values;
+	int maxValues = 64;
+	int nrValues = 0;
+	int nameLength;
+	char* variableName;
+	Oid type;
+	bool isModified;
+	int valueLength;
+	SessionVariable* variable;
+	bool found;
+	Oid receiveFunctionOid;
+	Oid typeIOParam;
+	int i;
+
+	if (PG_ARGISNULL(0))
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("state must be filled"))));
+	}
+
+	if (virgin)
+	{
+		reload();
+	}
+
+	elog(DEBUG1, "@>import_state()");
+
+	state = PG_GETARG_BYTEA_PP(0);
+	buffer.data = VARDATA_ANY(state);
+	buffer.len = VARSIZE_ANY_EXHDR(state);
+	buffer.maxlen = buffer.len;
+	buffer.cursor = 0;
+
+	if (pq_getmsgint(&buffer, 4) != EXPORTED_STATE_FORMAT
+			|| pq_getmsgint(&buffer, 4) != MyDatabaseId)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("state is not exported by session_variable.export_state() in this database"))));
+	}
+
+	values = palloc(maxValues * sizeof(ExportedValue));
+	initStringInfo(&valueBuffer);
+	while ((nameLength = (int) pq_getmsgint(&buffer, 4)) != 0)
+	{
+		variableName = pnstrdup(pq_getmsgbytes(&buffer, nameLength),
+				nameLength);
+		type = pq_getmsgint(&buffer, 4);
+		isModified = pq_getmsgbyte(&buffer) != 0;
+		valueLength = (int) pq_getmsgint(&buffer, 4);
+
+		variable = searchVariable(variableName, &variables, &found);
+		if (!found || variable->isConstant)
 		{
-			content = (Datum) PG_GETARG_VARLENA_P(2);
+			ereport(ERROR,
+					(errcode(ERRCODE_NO_DATA_FOUND), (errmsg("variable \"%s\" does not exists", variableName))));
 		}
-		else
+		if (variable->type != type)
 		{
-			content = PG_GETARG_DATUM(2);
+			ereport(ERROR,
+					(errcode(ERRCODE_DATATYPE_MISMATCH), (errmsg("the type of variable \"%s\" has changed since the state was exported", variableName))));
 		}
 
-		/*
-		 * Make sure the new content is malloced instead of palloced, and cast to the right type of course.
-		 */
-		content = coerceInput(contentTypeOid, typeOid, typeLength, content,
-				&castFailed);
-		if (castFailed)
+		if (nrValues == maxValues)
+		{
+			maxValues *= 2;
+			values = repalloc(values, maxValues * sizeof(ExportedValue));
+		}
+		values[nrValues].variable = variable;
+		values[nrValues].isModified = isModified;
+		values[nrValues].isNull = valueLength < 0;
+		values[nrValues].value = (Datum) 0;
+		if (valueLength >= 0)
 		{
 			/*
-			 * Something went wrong, but that has already been logged
+			 * The receive function wants a null terminated buffer that it
+			 * consumes completely
 			 */
-			PG_RETURN_BOOL(false);
+			resetStringInfo(&valueBuffer);
+			appendBinaryStringInfo(&valueBuffer,
+					pq_getmsgbytes(&buffer, valueLength), valueLength);
+			getTypeBinaryInputInfo(type, &receiveFunctionOid, &typeIOParam);
+			values[nrValues].value = OidReceiveFunctionCall(receiveFunctionOid,
+					&valueBuffer, typeIOParam, -1);
+			if (valueBuffer.cursor != valueBuffer.len)
+			{
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION), (errmsg("incorrect binary data format for variable \"%s\"", variableName))));
+			}
 		}
+		nrValues++;
+		pfree(variableName);
 	}
+	pq_getmsgend(&buffer);
 
-	result = saveNewVariable(variableName, false, type, typeLength, isNull,
-			content);
+	for (i = 0; i < nrValues; i++)
+	{
+		rememberTransactionScopedValue(values[i].variable);
+		setContent(values[i].variable, values[i].variable->type,
+				values[i].isNull, values[i].value);
+		values[i].variable->isModified = values[i].isModified;
+	}
 
-	elog(DEBUG1, "@<create_variable('%s')", variableNameStr);
+	elog(DEBUG1, "@<import_state() = %d", nrValues);
 
-	PG_RETURN_BOOL(result);
+	PG_RETURN_INT32(nrValues);
 }
 
 /*
- * create_constant(constant_name text, constant_type regtype, value anyelement) returns boolean
+ * Returns the result set variable with the given name
+ *
+ * @param char* name - Name of the result set variable
+ * @return RowSet* - The result set variable, or NULL if it does not exist
  */
-PG_FUNCTION_INFO_V1(create_constant);
-PGDLLEXPORT Datum create_constant( PG_FUNCTION_ARGS)
+RowSet* findRowSet(char* name)
 {
-	text* variableName = NULL;
-	Oid type = InvalidOid;
-	Oid typeOid = InvalidOid;
-	Datum content = (Datum) NULL;
-	Oid contentTypeOid;
-	int typeLength;
-	int contentTypeLength;
-	bool result;
-	bool castFailed;
-	char* variableNameStr;
+	RowSet* rowSet;
 
-	if (virgin)
+	for (rowSet = rowSets; rowSet != NULL; rowSet = rowSet->next)
 	{
-		reload();
+		if (strcmp(rowSet->name, name) == 0)
+		{
+			return rowSet;
+		}
 	}
+	return NULL;
+}
 
-	if (PG_NARGS() != 3)
+/*
+ * Removes the result set variable with the given name, if it exists, and
+ * releases its tuple store
+ *
+ * @param char* name - Name of the result set variable
+ */
+void forgetRowSet(char* name)
+{
+	RowSet** link;
+	RowSet* rowSet;
+
+	for (link = &rowSets; *link != NULL; link = &(*link)->next)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.create_constant(constant_name text, constant_type regtype, value anyelement)"))));
-		PG_RETURN_NULL()
-		;
+		if (strcmp((*link)->name, name) == 0)
+		{
+			rowSet = *link;
+			*link = rowSet->next;
+			tuplestore_end(rowSet->rows);
+			MemoryContextDelete(rowSet->context);
+			return;
+		}
 	}
+}
 
-	if (PG_ARGISNULL(0))
+/*
+ * Removes all result set variables of the session
+ */
+void forgetRowSets(void)
+{
+	RowSet* rowSet;
+
+	while (rowSets != NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("constant name must be filled"))));
-		PG_RETURN_BOOL(false);
+		rowSet = rowSets;
+		rowSets = rowSet->next;
+		tuplestore_end(rowSet->rows);
+		MemoryContextDelete(rowSet->context);
 	}
-	variableName = PG_GETARG_TEXT_P(0);
+}
 
-	if (PG_ARGISNULL(1))
+/*
+ * function session_variable.set_rows(variable_name text, query text)
+ * returns bigint
+ *
+ * Executes the query and keeps its rows as result set variable variable_name
+ * of the session, replacing the rows that it had. The rows are kept in a tuple
+ * store that spills to a temporary file beyond work_mem. A null query removes
+ * the result set variable.
+ *
+ * The query is executed with the privileges of the invoker.
+ *
+ * @return bigint - The number of rows
+ */
+PG_FUNCTION_INFO_V1(set_rows);
+PGDLLEXPORT Datum set_rows( PG_FUNCTION_ARGS)
+{
+	char* variableName;
+	char* query;
+	RowSet* rowSet;
+	MemoryContext rowSetContext;
+	MemoryContext oldContext;
+	Portal cursor;
+	uint64 i;
+
+	if (PG_NARGS() != 2)
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("constant type must be filled"))));
-		PG_RETURN_BOOL(false);
+				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg("Usage: session_variable.set_rows(variable_name text, query text)"))));
+		PG_RETURN_NULL();
 	}
-	type = PG_GETARG_OID(1);
-	typeOid = DatumGetObjectId(type);
-	if (!checkTypeType(typeOid))
+
+	if (PG_ARGISNULL(0))
 	{
-		PG_RETURN_BOOL(false);
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable name must be filled"))));
+		PG_RETURN_NULL();
 	}
-	typeLength = getTypeLength(typeOid);
-
-	variableNameStr = text_to_cstring(variableName);
-	elog(DEBUG1, "@>create_constant('%s')", variableNameStr);
-	if (!strlen(variableNameStr))
+	variableName = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	if (strlen(variableName) == 0)
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable name must be filled"))));
+		PG_RETURN_NULL();
 	}
 
-	if (!PG_ARGISNULL(2))
+	elog(DEBUG1, "@>set_rows('%s')", variableName);
+
+	if (PG_ARGISNULL(1))
 	{
-		contentTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 2);
-		if (typeOid == contentTypeOid)
-		{
-			contentTypeLength = typeLength;
-		}
-		else
-		{
-			contentTypeLength = getTypeLength(contentTypeOid);
-		}
-		if (contentTypeLength < 0)
-		{
-			content = (Datum) PG_GETARG_VARLENA_P(2);
-		}
-		else
-		{
-			content = PG_GETARG_DATUM(2);
-		}
+		forgetRowSet(variableName);
+		elog(DEBUG1, "@<set_rows('%s') = 0", variableName);
+		PG_RETURN_INT64(0);
+	}
+	query = text_to_cstring(PG_GETARG_TEXT_PP(1));
 
-		/*
-		 * Make sure the new content is malloced instead of palloced, and cast to the right type of course.
-		 */
-		content = coerceInput(contentTypeOid, typeOid, typeLength, content,
-				&castFailed);
-		if (castFailed)
+	/*
+	 * The rows are collected in a context that only becomes session long
+	 * when the query succeeds. The tuple store is inter transaction, so its
+	 * temporary file is not closed at the end of the transaction.
+	 */
+	rowSetContext = AllocSetContextCreate(CurrentMemoryContext,
+			"session_variable row set", ALLOCSET_DEFAULT_SIZES);
+	oldContext = MemoryContextSwitchTo(rowSetContext);
+	rowSet = (RowSet*) palloc(offsetof(RowSet, name) + strlen(variableName) + 1);
+	strcpy(rowSet->name, variableName);
+	rowSet->context = rowSetContext;
+	rowSet->rowCount = 0;
+	rowSet->tupleDesc = NULL;
+	rowSet->rows = tuplestore_begin_heap(true, true, work_mem);
+	MemoryContextSwitchTo(oldContext);
+
+	PG_TRY();
+	{
+		SPI_connect();
+		cursor = SPI_cursor_open_with_args(NULL, query, 0, NULL, NULL, NULL,
+				false, CURSOR_OPT_NO_SCROLL);
+		oldContext = MemoryContextSwitchTo(rowSetContext);
+		rowSet->tupleDesc = CreateTupleDescCopy(cursor->tupDesc);
+		MemoryContextSwitchTo(oldContext);
+
+		SPI_cursor_fetch(cursor, true, 1000);
+		while (SPI_processed > 0)
 		{
-			/*
-			 * Something went wrong, but that has already been logged
-			 */
-			PG_RETURN_BOOL(false);
+			for (i = 0; i < SPI_processed; i++)
+			{
+				tuplestore_puttuple(rowSet->rows, SPI_tuptable->vals[i]);
+			}
+			rowSet->rowCount += SPI_processed;
+			SPI_freetuptable(SPI_tuptable);
+			SPI_cursor_fetch(cursor, true, 1000);
 		}
+		SPI_cursor_close(cursor);
+		SPI_finish();
 	}
+	PG_CATCH();
+	{
+		tuplestore_end(rowSet->rows);
+		MemoryContextDelete(rowSetContext);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
 
-	result = saveNewVariable(variableName, true, type, typeLength,
-			PG_ARGISNULL(2), content);
+	forgetRowSet(variableName);
+	MemoryContextSetParent(rowSetContext, TopMemoryContext);
+	rowSet->next = rowSets;
+	rowSets = rowSet;
 
-	elog(DEBUG1, "@<create_constant('%s')", variableNameStr);
+	elog(DEBUG1, "@<set_rows('%s') = " INT64_FORMAT, variableName,
+			rowSet->rowCount);
 
-	PG_RETURN_BOOL(result);
+	PG_RETURN_INT64(rowSet->rowCount);
 }
 
 /*
- * drop(variable_constant_name text) returns boolean true
+ * function session_variable.rows(variable_name text, row_type anyelement)
+ * returns setof anyelement
+ *
+ * Returns the rows of result set variable variable_name. The row_type argument
+ * only determines the result type: a composite type with the same column types
+ * as the query of set_rows(), or the type of its only column.
  */
-PG_FUNCTION_INFO_V1(drop);
-PGDLLEXPORT Datum drop( PG_FUNCTION_ARGS)
+PG_FUNCTION_INFO_V1(rows);
+PGDLLEXPORT Datum rows( PG_FUNCTION_ARGS)
 {
-	text* variableNameArg;
+	ReturnSetInfo* rsinfo = (ReturnSetInfo*) fcinfo->resultinfo;
 	char* variableName;
-	SessionVariable *variable = NULL, **higherLvl, *replacement, *aboveReplacement;
-	int diff;
+	RowSet* rowSet;
+	TypeFuncClass resultClass;
+	Oid resultTypeOid;
+	TupleDesc resultDesc;
+	Tuplestorestate* tupleStore;
+	TupleTableSlot* slot;
+	MemoryContext oldContext;
+	bool matches;
+	int i;
 
-	if (virgin)
+	if (PG_NARGS() != 2)
 	{
-		reload();
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg("Usage: session_variable.rows(variable_name text, row_type anyelement)"))));
+		PG_RETURN_NULL();
 	}
 
-	if (PG_NARGS() != 1)
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo)
+			|| !(rsinfo->allowedModes & SFRM_Materialize))
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.drop(variable_or_constant_name text)"))));
-		PG_RETURN_BOOL(false);
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), (errmsg("set-valued function called in context that cannot accept a set"))));
 	}
 
 	if (PG_ARGISNULL(0))
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
-		PG_RETURN_BOOL(false);
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable name must be filled"))));
+		PG_RETURN_NULL();
 	}
-	variableNameArg = PG_GETARG_TEXT_P(0);
-	variableName = text_to_cstring(variableNameArg);
+	variableName = text_to_cstring(PG_GETARG_TEXT_PP(0));
 
-	elog(DEBUG1, "@>drop('%s')", variableName);
-	if (!strlen(variableName))
+	elog(DEBUG1, "@>rows('%s')", variableName);
+
+	rowSet = findRowSet(variableName);
+	if (rowSet == NULL)
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable or constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+				(errcode(ERRCODE_NO_DATA), (errmsg("result set variable \"%s\" does not exist", variableName))));
+		PG_RETURN_NULL();
 	}
 
-	higherLvl = &variables;
-	while (*higherLvl != NULL)
+	resultClass = get_call_result_type(fcinfo, &resultTypeOid, &resultDesc);
+	if (resultClass == TYPEFUNC_COMPOSITE)
 	{
-		variable = *higherLvl;
-
-		diff = strcmp(variableName, variable->name);
-
-		if (diff < 0)
-		{
-			higherLvl = &variable->prior;
-			logVariable(DEBUG4, "searching: prior = ", variable);
-		}
-		else if (diff > 0)
-		{
-			higherLvl = &variable->next;
-			logVariable(DEBUG4, "searching: next = ", variable);
-		}
-		else
+		matches = resultDesc->natts == rowSet->tupleDesc->natts;
+		for (i = 0; matches && i < resultDesc->natts; i++)
 		{
-			break;
+			matches = !TupleDescAttr(resultDesc, i)->attisdropped
+					&& TupleDescAttr(resultDesc, i)->atttypid
+							== TupleDescAttr(rowSet->tupleDesc, i)->atttypid;
 		}
 	}
-
-	if (*higherLvl == NULL)
+	else if (resultClass == TYPEFUNC_SCALAR)
+	{
+		matches = rowSet->tupleDesc->natts == 1
+				&& TupleDescAttr(rowSet->tupleDesc, 0)->atttypid == resultTypeOid;
+	}
+	else
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant \"%s\" does not exists", variableName ))));
-		PG_RETURN_BOOL(false);
+				(errcode(ERRCODE_DATATYPE_MISMATCH), (errmsg("row_type must be a composite or scalar type"))));
+		PG_RETURN_NULL();
+	}
+	if (!matches)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH), (errmsg("rows of result set variable \"%s\" do not match type %s", variableName, getTypeName(resultTypeOid)))));
+		PG_RETURN_NULL();
 	}
 
-	logVariable(DEBUG4, "variable to drop = ", variable);
-	if (variable->prior == NULL)
+	oldContext = MemoryContextSwitchTo(
+			rsinfo->econtext->ecxt_per_query_memory);
+	if (resultClass == TYPEFUNC_SCALAR)
 	{
-		*higherLvl = variable->next;
+		resultDesc = CreateTupleDescCopy(rowSet->tupleDesc);
 	}
-	else if (variable->next == NULL)
+	tupleStore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupleStore;
+	rsinfo->setDesc = resultDesc;
+
+	slot = MakeSingleTupleTableSlot(rowSet->tupleDesc, &TTSOpsMinimalTuple);
+	tuplestore_rescan(rowSet->rows);
+	while (tuplestore_gettupleslot(rowSet->rows, true, false, slot))
 	{
-		*higherLvl = variable->prior;
+		tuplestore_puttupleslot(tupleStore, slot);
 	}
-	else
+	ExecDropSingleTupleTableSlot(slot);
+	MemoryContextSwitchTo(oldContext);
+
+	elog(DEBUG1, "@<rows('%s') = " INT64_FORMAT " rows", variableName,
+			rowSet->rowCount);
+
+	return (Datum) 0;
+}
+
+/*
+ * function session_variable.rows_support(internal) returns internal
+ *
+ * Planner support function of session_variable.rows(), that estimates the
+ * number of rows as the number of rows that the result set variable has at
+ * planning time.
+ */
+PG_FUNCTION_INFO_V1(rows_support);
+PGDLLEXPORT Datum rows_support( PG_FUNCTION_ARGS)
+{
+	Node* rawRequest = (Node*) PG_GETARG_POINTER(0);
+	SupportRequestRows* request;
+	Node* nameArgument;
+	RowSet* rowSet;
+
+	if (!IsA(rawRequest, SupportRequestRows))
 	{
-		aboveReplacement = NULL;
-		replacement = variable->prior;
-		while (replacement->next != NULL)
-		{
-			aboveReplacement = replacement;
-			replacement = replacement->next;
-		}
-		logVariable(DEBUG4, "replacement before = ", replacement);
-		logVariable(DEBUG4, "aboveReplacement before = ", replacement);
-		if (aboveReplacement != NULL)
-		{
-			aboveReplacement->next = replacement->prior;
-			logVariable(DEBUG4, "aboveReplacement after = ", aboveReplacement);
-		}
-		if (variable->prior != replacement)
-		{
-			replacement->prior = variable->prior;
-		}
-		replacement->next = variable->next;
-		*higherLvl = replacement;
-		logVariable(DEBUG4, "replacement after = ", replacement);
+		PG_RETURN_POINTER(NULL);
+	}
+	request = (SupportRequestRows*) rawRequest;
+	if (request->node == NULL || !IsA(request->node, FuncExpr))
+	{
+		PG_RETURN_POINTER(NULL);
 	}
 
-	variable->prior = NULL;
-	variable->next = NULL;
-	removeVariableRecursively(variable);
+	nameArgument = linitial(((FuncExpr*) request->node)->args);
+	if (!IsA(nameArgument, Const) || ((Const*) nameArgument)->constisnull)
+	{
+		PG_RETURN_POINTER(NULL);
+	}
 
-	deleteVariable(variableNameArg);
+	rowSet = findRowSet(
+			TextDatumGetCString(((Const*) nameArgument)->constvalue));
+	if (rowSet == NULL)
+	{
+		PG_RETURN_POINTER(NULL);
+	}
 
-	elog(DEBUG1, "@<drop('%s') = true", variableName);
-	PG_RETURN_BOOL(true);
+	request->rows = (double) rowSet->rowCount;
+	PG_RETURN_POINTER(request);
 }
 
 /*
- * alter_value(variable_constant_name text, value anyelement) returns anyelement
+ * function session_variable.backend_stats() returns record
+ *
+ * Returns the usage counters of the current session together with the number
+ * of variables, the memory they hold and the depth of the b-tree.
  */
-PG_FUNCTION_INFO_V1(alter_value);
-PGDLLEXPORT Datum alter_value( PG_FUNCTION_ARGS)
+PG_FUNCTION_INFO_V1(backend_stats);
+PGDLLEXPORT Datum backend_stats( PG_FUNCTION_ARGS)
 {
-	char* variableName = NULL;
-	SessionVariable* variable;
+	TupleDesc tupleDesc;
+	Datum values[15];
+	bool nulls[15];
+	int nrVariables = 0;
+	int treeDepth = 0;
+	int64 nameBytes = 0;
+	int64 valueBytes = 0;
+
+	if (get_call_result_type(fcinfo, NULL, &tupleDesc) != TYPEFUNC_COMPOSITE)
+	{
+		elog(ERROR, "return type must be a row type");
+	}
+	tupleDesc = BlessTupleDesc(tupleDesc);
+
+	collectTreeStatistics(variables, 1, &nrVariables, &treeDepth, &nameBytes,
+			&valueBytes);
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(statistics.getCalls);
+	values[1] = Int64GetDatum(statistics.setCalls);
+	values[2] = Int64GetDatum(statistics.existsCalls);
+	values[3] = Int64GetDatum(statistics.reloadCalls);
+	values[4] = Float8GetDatum(statistics.reloadTotalTime / 1000.0);
+	values[5] = Float8GetDatum(statistics.reloadMaxTime / 1000.0);
+	values[6] = Int32GetDatum(nrVariables);
+	values[7] = Int64GetDatum(nameBytes);
+	values[8] = Int64GetDatum(valueBytes);
+	values[9] = Int32GetDatum(treeDepth);
+	values[10] = Int64GetDatum(statistics.relabelCoercions);
+	values[11] = Int64GetDatum(statistics.funcCoercions);
+	values[12] = Int64GetDatum(statistics.ioCoercions);
+	values[13] = Int64GetDatum(statistics.coercionCacheHits);
+	values[14] = Int64GetDatum(statistics.preloadedReloads);
+
+	PG_RETURN_DATUM(
+			HeapTupleGetDatum(heap_form_tuple(tupleDesc, values, nulls)));
+}
+
+/*
+ * Defines the GUCs of the shared statistics, the shared constants and the
+ * preloaded catalog and requests the shared memory for them. Invoked from
+ * _PG_init() when loaded via shared_preload_libraries.
+ */
+void defineSharedMemory(void)
+{
+	defineSharedStatistics();
+	defineSharedConstants();
+	definePreloadedCatalog();
+
+#if PG_VERSION_NUM >= 150000
+	previousShmemRequestHook = shmem_request_hook;
+	shmem_request_hook = sharedMemoryShmemRequest;
+#else
+	RequestAddinShmemSpace(
+			add_size(add_size(sharedStatisticsSize(), sharedConstantsSize()),
+					preloadedCatalogSize()));
+	RequestNamedLWLockTranche("session_variable", 3);
+#endif
+	previousShmemStartupHook = shmem_startup_hook;
+	shmem_startup_hook = sharedMemoryShmemStartup;
+}
+
+/*
+ * Defines the GUCs of the shared statistics
+ */
+void defineSharedStatistics(void)
+{
+	DefineCustomIntVariable("session_variable.stats_max",
+			"Maximum number of variables tracked in the shared statistics.",
+			NULL, &sharedStatisticsMax, 1000, 100, INT_MAX / 2, PGC_POSTMASTER,
+			0, NULL, NULL, NULL);
+	DefineCustomIntVariable("session_variable.stats_flush_interval",
+			"Minimum time between flushes of session local usage into the shared statistics.",
+			NULL, &sharedStatisticsFlushInterval, 10, 0, 3600, PGC_SIGHUP,
+			GUC_UNIT_S, NULL, NULL, NULL);
+}
+
+/*
+ * Defines the GUCs of the shared constants
+ */
+void defineSharedConstants(void)
+{
+	DefineCustomIntVariable("session_variable.shared_constants_max",
+			"Maximum number of constants kept in shared memory, 0 keeps all constants session local.",
+			NULL, &sharedConstantsMax, 1000, 0, INT_MAX / 2, PGC_POSTMASTER,
+			0, NULL, NULL, NULL);
+}
+
+/*
+ * @return Size - The amount of shared memory needed for the shared statistics
+ */
+Size sharedStatisticsSize(void)
+{
+	return hash_estimate_size(sharedStatisticsMax,
+			sizeof(SharedStatisticsEntry));
+}
+
+/*
+ * @return Size - The amount of shared memory needed for the name index of the
+ *                shared constants. Their values are kept in a dsa area.
+ */
+Size sharedConstantsSize(void)
+{
+	if (sharedConstantsMax == 0)
+	{
+		return 0;
+	}
+	return add_size(MAXALIGN(sizeof(SharedConstantsControl)),
+			hash_estimate_size(sharedConstantsMax, sizeof(SharedConstant)));
+}
+
+#if PG_VERSION_NUM >= 150000
+/*
+ * shmem_request_hook: requests the shared memory for the shared statistics,
+ * the shared constants and the preloaded catalog
+ */
+void sharedMemoryShmemRequest(void)
+{
+	if (previousShmemRequestHook)
+	{
+		previousShmemRequestHook();
+	}
+	RequestAddinShmemSpace(
+			add_size(add_size(sharedStatisticsSize(), sharedConstantsSize()),
+					preloadedCatalogSize()));
+	RequestNamedLWLockTranche("session_variable", 3);
+}
+#endif
+
+/*
+ * shmem_startup_hook: creates or attaches to the shared statistics hash table,
+ * the name index of the shared constants and the preloaded catalog
+ */
+void sharedMemoryShmemStartup(void)
+{
+	HASHCTL info;
+	LWLockPadded* locks;
 	bool found;
-	Datum newContent = (Datum) NULL;
-	Oid newValueTypeOid;
-	int newValueTypeLength;
-	bool castFailed;
 
-	if (virgin)
+	if (previousShmemStartupHook)
 	{
-		reload();
+		previousShmemStartupHook();
 	}
 
-	if (PG_NARGS() != 2)
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+	locks = GetNamedLWLockTranche("session_variable");
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(SharedStatisticsKey);
+	info.entrysize = sizeof(SharedStatisticsEntry);
+	sharedStatisticsLock = &locks[0].lock;
+	sharedStatistics = ShmemInitHash("session_variable statistics",
+			sharedStatisticsMax, sharedStatisticsMax, &info,
+			HASH_ELEM | HASH_BLOBS);
+
+	if (sharedConstantsMax > 0)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.alter_value(variable_name text, value anyelement)"))));
-		PG_RETURN_NULL()
-		;
+		sharedConstantsControl = ShmemInitStruct(
+				"session_variable constants control",
+				sizeof(SharedConstantsControl), &found);
+		if (!found)
+		{
+			sharedConstantsControl->trancheId = LWLockNewTrancheId();
+			sharedConstantsControl->area = DSA_HANDLE_INVALID;
+			sharedConstantsControl->version = 0;
+		}
+
+		memset(&info, 0, sizeof(info));
+		info.keysize = sizeof(SharedConstantKey);
+		info.entrysize = sizeof(SharedConstant);
+		sharedConstantsLock = &locks[1].lock;
+		sharedConstants = ShmemInitHash("session_variable constants",
+				sharedConstantsMax, sharedConstantsMax, &info,
+				HASH_ELEM | HASH_BLOBS);
 	}
 
-	if (PG_ARGISNULL(0))
+	if (preloadDatabase != NULL && *preloadDatabase != '\0')
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+		preloadedCatalog = ShmemInitStruct("session_variable preloaded catalog",
+				sizeof(PreloadedCatalog), &found);
+		if (!found)
+		{
+			memset(preloadedCatalog, 0, sizeof(PreloadedCatalog));
+			preloadedCatalog->trancheId = LWLockNewTrancheId();
+			preloadedCatalog->area = DSA_HANDLE_INVALID;
+			preloadedCatalog->image = InvalidDsaPointer;
+		}
+		preloadedCatalogLock = &locks[2].lock;
 	}
+	LWLockRelease(AddinShmemInitLock);
+}
 
-	variableName = text_to_cstring((text *) PG_GETARG_TEXT_P(0));
+/*
+ * Attaches to the dsa area that holds the values of the shared constants,
+ * creating it if this is the first session that needs it. The area stays
+ * mapped until the end of the session.
+ *
+ * @return dsa_area* - The area
+ */
+dsa_area* getSharedConstantsArea(void)
+{
+	MemoryContext oldContext;
 
-	elog(DEBUG1, "@>alter_value('%s')", variableName);
+	if (sharedConstantsArea != NULL)
+	{
+		return sharedConstantsArea;
+	}
 
-	if (!strlen(variableName))
+	LWLockRegisterTranche(sharedConstantsControl->trancheId,
+			"session_variable constants");
+	oldContext = MemoryContextSwitchTo(TopMemoryContext);
+	LWLockAcquire(sharedConstantsLock, LW_EXCLUSIVE);
+	if (sharedConstantsControl->area == DSA_HANDLE_INVALID)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable or constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+		sharedConstantsArea = dsa_create(sharedConstantsControl->trancheId);
+		dsa_pin(sharedConstantsArea);
+		sharedConstantsControl->area = dsa_get_handle(sharedConstantsArea);
 	}
+	else
+	{
+		sharedConstantsArea = dsa_attach(sharedConstantsControl->area);
+	}
+	LWLockRelease(sharedConstantsLock);
+	dsa_pin_mapping(sharedConstantsArea);
+	MemoryContextSwitchTo(oldContext);
 
-	variable = searchVariable(variableName, &variables, &found);
-	if (!found)
+	return sharedConstantsArea;
+}
+
+/*
+ * Defines session_variable.preload_database and registers the preload worker
+ * if it is set
+ */
+void definePreloadedCatalog(void)
+{
+	BackgroundWorker worker;
+
+	DefineCustomStringVariable("session_variable.preload_database",
+			"Database of which a background worker keeps the catalog in shared memory for new sessions.",
+			NULL, &preloadDatabase, NULL, PGC_POSTMASTER, 0, NULL, NULL, NULL);
+
+	if (preloadDatabase == NULL || *preloadDatabase == '\0')
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NO_DATA),(errmsg("Variable \"%s\" does not exists", variableName))));
-		PG_RETURN_NULL()
-		;
+		return;
 	}
 
-	newValueTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 1);
-	if (variable->type == newValueTypeOid)
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS
+			| BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = 10;
+	strlcpy(worker.bgw_library_name, "session_variable", BGW_MAXLEN);
+	strlcpy(worker.bgw_function_name, "preloadWorkerMain", BGW_MAXLEN);
+	strlcpy(worker.bgw_name, "session_variable preload", BGW_MAXLEN);
+	strlcpy(worker.bgw_type, "session_variable preload", BGW_MAXLEN);
+	RegisterBackgroundWorker(&worker);
+}
+
+/*
+ * @return Size - The amount of shared memory needed for the preloaded catalog.
+ *                The catalog itself is kept in a dsa area.
+ */
+Size preloadedCatalogSize(void)
+{
+	if (preloadDatabase == NULL || *preloadDatabase == '\0')
 	{
-		newValueTypeLength = variable->typeLength;
+		return 0;
+	}
+	return MAXALIGN(sizeof(PreloadedCatalog));
+}
+
+/*
+ * Attaches to the dsa area that holds the preloaded catalog, creating it if
+ * this is the first process that needs it. The area stays mapped until the end
+ * of the process.
+ *
+ * @return dsa_area* - The area
+ */
+dsa_area* getPreloadedCatalogArea(void)
+{
+	MemoryContext oldContext;
+
+	if (preloadedCatalogArea != NULL)
+	{
+		return preloadedCatalogArea;
+	}
+
+	LWLockRegisterTranche(preloadedCatalog->trancheId,
+			"session_variable preloaded catalog");
+	oldContext = MemoryContextSwitchTo(TopMemoryContext);
+	LWLockAcquire(preloadedCatalogLock, LW_EXCLUSIVE);
+	if (preloadedCatalog->area == DSA_HANDLE_INVALID)
+	{
+		preloadedCatalogArea = dsa_create(preloadedCatalog->trancheId);
+		dsa_pin(preloadedCatalogArea);
+		preloadedCatalog->area = dsa_get_handle(preloadedCatalogArea);
 	}
 	else
 	{
-		newValueTypeLength = getTypeLength(newValueTypeOid);
+		preloadedCatalogArea = dsa_attach(preloadedCatalog->area);
+	}
+	LWLockRelease(preloadedCatalogLock);
+	dsa_pin_mapping(preloadedCatalogArea);
+	MemoryContextSwitchTo(oldContext);
+
+	return preloadedCatalogArea;
+}
+
+/*
+ * Main function of the preload worker. Connects to
+ * session_variable.preload_database and loads its catalog again whenever a
+ * change of the catalog has been committed.
+ *
+ * @param Datum argument - Not used
+ */
+void preloadWorkerMain(Datum argument)
+{
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+	BackgroundWorkerInitializeConnection(preloadDatabase, NULL, 0);
+
+	LWLockAcquire(preloadedCatalogLock, LW_EXCLUSIVE);
+	preloadedCatalog->databaseOid = MyDatabaseId;
+	preloadedCatalog->workerLatch = MyLatch;
+	LWLockRelease(preloadedCatalogLock);
+
+	for (;;)
+	{
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+
+		preloadCatalog();
+
+		(void) WaitLatch(MyLatch, WL_LATCH_SET | WL_EXIT_ON_PM_DEATH, 0,
+				PG_WAIT_EXTENSION);
 	}
+}
 
-	if (PG_ARGISNULL(1))
+/*
+ * Loads the catalog in the preload worker and publishes it in the dsa area of
+ * the preloaded catalog, unless the published catalog is up to date. No
+ * catalog is published if session_variable.variable_overrides has rows,
+ * because their values depend on the session, or if the extension is not
+ * installed (in this version).
+ */
+void preloadCatalog(void)
+{
+	char* sql = psprintf("select exists (select 1 from pg_catalog.pg_extension"
+			" where extname = 'session_variable' and extversion = '%s')"
+			" and not exists (select 1 from session_variable.variable_overrides)",
+			sessionVariableVersion);
+	uint64 generation;
+	bool isCurrent;
+	bool isUsable = false;
+	bool isNull;
+	SessionVariable* tree;
+	StringInfoData image;
+	int nrVariables = 0;
+	dsa_area* area = getPreloadedCatalogArea();
+	dsa_pointer newImage = InvalidDsaPointer;
+	dsa_pointer oldImage;
+
+	/*
+	 * A change that commits after the generation has been read raises it
+	 * again, so it is loaded in the next round
+	 */
+	LWLockAcquire(preloadedCatalogLock, LW_SHARED);
+	generation = preloadedCatalog->generation;
+	isCurrent = preloadedCatalog->isLoaded
+			&& preloadedCatalog->imageGeneration == generation;
+	LWLockRelease(preloadedCatalogLock);
+	if (isCurrent)
 	{
-		newContent = (Datum) NULL;
+		pfree(sql);
+		return;
 	}
-	else
-	{
 
-		if (newValueTypeLength < 0)
-		{
-			newContent = (Datum) PG_GETARG_VARLENA_P(1);
-		}
-		else
-		{
-			newContent = PG_GETARG_DATUM(1);
-		}
+	SetCurrentStatementStartTimestamp();
+	StartTransactionCommand();
+	PushActiveSnapshot(GetTransactionSnapshot());
+	pgstat_report_activity(STATE_RUNNING, "preloading session_variable catalog");
 
-		/*
-		 * Make sure the new content is malloced instead of palloced, and cast to the right type of course.
-		 */
-		newContent = coerceInput(newValueTypeOid, variable->type,
-				variable->typeLength, newContent, &castFailed);
-		if (castFailed)
+	if (OidIsValid(get_extension_oid("session_variable", true)))
+	{
+		SPI_connect();
+		if (SPI_execute(sql, true, 1) == SPI_OK_SELECT && SPI_processed == 1)
 		{
-			/*
-			 * Something went wrong, but that has already been logged
-			 */
-
-			PG_RETURN_NULL()
-			;
+			isUsable = DatumGetBool(
+					SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc,
+							1, &isNull));
 		}
+		SPI_finish();
 	}
 
-	if (!variable->isNull
-			&& (variable->typeLength < 0 || variable->typeLength > SIZEOF_DATUM))
+	initStringInfo(&image);
+	if (isUsable)
 	{
-		/*
-		 * The prior content has been malloced instead of palloced, so must be freed here.
-		 */
-		free((void*) variable->content);
+		tree = buildBTree(loadVariables("true", 0, NULL, &nrVariables));
+		appendBinaryStringInfo(&image, (char*) &nrVariables,
+				sizeof(nrVariables));
+		serializeVariables(tree, &image);
+		removeVariableRecursively(tree);
+
+		newImage = dsa_allocate_extended(area, image.len, DSA_ALLOC_HUGE);
+		memcpy(dsa_get_address(area, newImage), image.data, image.len);
 	}
-	variable->isNull = PG_ARGISNULL(1);
-	variable->content = newContent;
 
-	updateVariable(variable);
+	/*
+	 * Sessions copy the image while holding the lock, so the previous image
+	 * can be freed after the exchange
+	 */
+	LWLockAcquire(preloadedCatalogLock, LW_EXCLUSIVE);
+	oldImage = preloadedCatalog->image;
+	preloadedCatalog->image = newImage;
+	preloadedCatalog->imageSize = isUsable ? image.len : 0;
+	preloadedCatalog->imageGeneration = generation;
+	preloadedCatalog->isLoaded = true;
+	LWLockRelease(preloadedCatalogLock);
+	if (DsaPointerIsValid(oldImage))
+	{
+		dsa_free(area, oldImage);
+	}
 
-	elog(DEBUG1, "@<alter_value('%s')", variableName);
+	pfree(image.data);
+	pfree(sql);
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+	pgstat_report_activity(STATE_IDLE, NULL);
 
-	PG_RETURN_BOOL(true);
+	elog(DEBUG1, "preloadCatalog() = %d", nrVariables);
 }
 
 /*
- * set(variable_name text, value anyelement) returns boolean
+ * Takes the variables from the preloaded catalog if it has been loaded from
+ * the current database and no change of the catalog has been committed since,
+ * and if the current transaction has not changed the catalog itself.
+ *
+ * @param SessionVariable** list - Is set to the variables in name order
+ * @param int* nrVariables - Is set to the number of variables
+ * @return bool - false if the variables are to be loaded from the catalog
  */
-PG_FUNCTION_INFO_V1(set);
-PGDLLEXPORT Datum set( PG_FUNCTION_ARGS)
+bool restorePreloadedCatalog(SessionVariable** list, int* nrVariables)
 {
-	char* variableName = NULL;
-	SessionVariable* variable;
-	bool found;
-	Datum newContent = (Datum) NULL;
-	Oid newValueTypeOid;
-	int newValueTypeLength;
-	bool castFailed;
+	char* image = NULL;
+	Size imageSize = 0;
+	dsa_area* area;
 
-	if (virgin)
+	if (preloadedCatalog == NULL || catalogChanged || IsParallelWorker()
+			|| (pendingWrites != NULL && hash_get_num_entries(pendingWrites) > 0))
 	{
-		reload();
+		return false;
 	}
 
-	if (PG_NARGS() != 2)
+	area = getPreloadedCatalogArea();
+	LWLockAcquire(preloadedCatalogLock, LW_SHARED);
+	if (preloadedCatalog->databaseOid == MyDatabaseId
+			&& preloadedCatalog->isLoaded
+			&& preloadedCatalog->imageGeneration == preloadedCatalog->generation
+			&& DsaPointerIsValid(preloadedCatalog->image))
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.set(variable_name text, value anyelement)"))));
-		PG_RETURN_NULL()
-		;
+		imageSize = preloadedCatalog->imageSize;
+		image = palloc(imageSize);
+		memcpy(image, dsa_get_address(area, preloadedCatalog->image),
+				imageSize);
 	}
+	LWLockRelease(preloadedCatalogLock);
 
-	if (PG_ARGISNULL(0))
+	if (image == NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable_name must be filled"))));
-		PG_RETURN_NULL()
-		;
+		return false;
 	}
 
-	variableName = text_to_cstring((text*) PG_GETARG_TEXT_P(0));
+	*list = restoreVariables(image, imageSize, nrVariables);
+	pfree(image);
 
-	elog(DEBUG1, "@>set('%s')", variableName);
+	elog(DEBUG3, "restorePreloadedCatalog() = %d", *nrVariables);
+	return true;
+}
 
-	if (!strlen(variableName))
+/*
+ * Remembers that the current transaction changes the catalog, so the preload
+ * worker is woken up at commit, see catalogXactCallback()
+ */
+PG_FUNCTION_INFO_V1(catalog_changed);
+PGDLLEXPORT Datum catalog_changed( PG_FUNCTION_ARGS)
+{
+	if (!CALLED_AS_TRIGGER(fcinfo))
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_ZERO_LENGTH_CHARACTER_STRING), (errmsg("variable name must be filled"))));
-		PG_RETURN_NULL()
-		;
+				(errcode(ERRCODE_E_R_I_E_TRIGGER_PROTOCOL_VIOLATED), (errmsg("catalog_changed() must be invoked as trigger"))));
 	}
 
-	variable = searchVariable(variableName, &variables, &found);
-	if (!found)
+	if (preloadedCatalog != NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NO_DATA),(errmsg("variable \"%s\" does not exists", variableName))));
-		PG_RETURN_NULL()
-		;
+		catalogChanged = true;
+		if (!catalogCallbackRegistered)
+		{
+			RegisterXactCallback(catalogXactCallback, NULL);
+			catalogCallbackRegistered = true;
+		}
 	}
 
-	if (variable->isConstant && !isExecutingInitialisationFunction) // the initialisation function is allowed to alter the value of a constant
-	{
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),(errmsg("constant \"%s\" cannot be set", variableName))));
-		PG_RETURN_NULL()
-		;
-	}
+	PG_RETURN_POINTER(NULL);
+}
 
-	newValueTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 1);
-	if (variable->type == newValueTypeOid)
+/*
+ * Raises the generation of the preloaded catalog when a transaction that
+ * changed the catalog of its database commits, and wakes up the preload worker
+ */
+void catalogXactCallback(XactEvent event, void* arg)
+{
+	Latch* workerLatch = NULL;
+
+	if (!catalogChanged)
 	{
-		newValueTypeLength = variable->typeLength;
+		return;
 	}
-	else
+
+	switch (event)
 	{
-		newValueTypeLength = getTypeLength(newValueTypeOid);
+	case XACT_EVENT_COMMIT:
+	case XACT_EVENT_PREPARE:
+		LWLockAcquire(preloadedCatalogLock, LW_EXCLUSIVE);
+		if (preloadedCatalog->databaseOid == MyDatabaseId)
+		{
+			preloadedCatalog->generation++;
+			workerLatch = preloadedCatalog->workerLatch;
+		}
+		LWLockRelease(preloadedCatalogLock);
+		if (workerLatch != NULL)
+		{
+			SetLatch(workerLatch);
+		}
+		catalogChanged = false;
+		break;
+	case XACT_EVENT_ABORT:
+		catalogChanged = false;
+		break;
+	default:
+		break;
 	}
+}
 
-	if (PG_ARGISNULL(1))
+/*
+ * @param char* constantName - The name of a constant in the current database
+ * @return SharedConstantKey - Its key in the shared constants
+ */
+SharedConstantKey sharedConstantKey(char* constantName)
+{
+	SharedConstantKey key;
+
+	memset(&key, 0, sizeof(key));
+	key.databaseOid = MyDatabaseId;
+	strlcpy(key.constantName, constantName, sizeof(key.constantName));
+	return key;
+}
+
+/*
+ * Publishes the value of a constant in the shared constants, replacing the
+ * previous version at once. The previous value is freed after the exchange,
+ * readers copy a value while holding the sharedConstantsLock.
+ *
+ * @param SessionVariable* variable - The constant
+ * @param Datum value - Its (uncompressed) value, not null
+ * @param Timestamp lastUpdated - last_updated_timestamp of the catalog row, 0
+ *                                if unknown
+ * @return bool - false if the shared constants are not enabled or full, or if
+ *                the name is too long
+ */
+bool publishSharedConstant(SessionVariable* variable, Datum value,
+		Timestamp lastUpdated)
+{
+	SharedConstantKey key;
+	SharedConstant* entry;
+	dsa_area* area;
+	dsa_pointer newContent = InvalidDsaPointer;
+	dsa_pointer oldContent = InvalidDsaPointer;
+	Size contentSize = 0;
+	bool byValue = variable->typeLength >= 0
+			&& variable->typeLength <= SIZEOF_DATUM;
+	bool found;
+
+	if (sharedConstants == NULL
+			|| variable->nameLength >= SHARED_CONSTANT_NAME_LENGTH)
 	{
-		newContent = (Datum) NULL;
+		return false;
 	}
-	else
-	{
 
-		if (newValueTypeLength < 0)
-		{
-			newContent = (Datum) PG_GETARG_VARLENA_P(1);
-		}
-		else
+	area = getSharedConstantsArea();
+	if (!byValue)
+	{
+		contentSize = datumGetSize(value, false, variable->typeLength);
+		newContent = dsa_allocate_extended(area, contentSize,
+				DSA_ALLOC_NO_OOM);
+		if (!DsaPointerIsValid(newContent))
 		{
-			newContent = PG_GETARG_DATUM(1);
+			return false;
 		}
+		memcpy(dsa_get_address(area, newContent), DatumGetPointer(value),
+				contentSize);
+	}
 
-		/*
-		 * Make sure the new content is malloced instead of palloced, and cast to the right type of course.
-		 */
-		newContent = coerceInput(newValueTypeOid, variable->type,
-				variable->typeLength, newContent, &castFailed);
-		if (castFailed)
+	key = sharedConstantKey(variable->name);
+	LWLockAcquire(sharedConstantsLock, LW_EXCLUSIVE);
+	entry = (SharedConstant*) hash_search(sharedConstants, &key,
+			HASH_ENTER_NULL, &found);
+	if (entry != NULL)
+	{
+		if (found)
 		{
-			/*
-			 * Something went wrong, but that has already been logged
-			 */
-
-			PG_RETURN_NULL()
-			;
+			oldContent = entry->sharedContent;
 		}
+		entry->type = variable->type;
+		entry->typeLength = variable->typeLength;
+		entry->lastUpdated = lastUpdated;
+		entry->version = ++sharedConstantsControl->version;
+		entry->content = byValue ? value : (Datum) NULL;
+		entry->sharedContent = newContent;
+		entry->contentSize = contentSize;
 	}
+	LWLockRelease(sharedConstantsLock);
 
-	if (!variable->isNull
-			&& (variable->typeLength < 0 || variable->typeLength > SIZEOF_DATUM))
+	if (entry == NULL)
 	{
-		/*
-		 * The prior content has been malloced instead of palloced, so must be freed here.
-		 */
-		free((void*) variable->content);
+		oldContent = newContent;
+	}
+	if (DsaPointerIsValid(oldContent))
+	{
+		dsa_free(area, oldContent);
 	}
+	return entry != NULL;
+}
 
-	variable->isNull = PG_ARGISNULL(1);
-	variable->content = newContent;
+/*
+ * Removes a constant from the shared constants, if it is there
+ *
+ * @param char* constantName - The name of the constant
+ */
+void unpublishSharedConstant(char* constantName)
+{
+	SharedConstantKey key;
+	SharedConstant* entry;
+	dsa_pointer oldContent = InvalidDsaPointer;
+
+	if (sharedConstants == NULL)
+	{
+		return;
+	}
 
-	elog(DEBUG1, "@<set('%s')", variableName);
+	key = sharedConstantKey(constantName);
+	LWLockAcquire(sharedConstantsLock, LW_EXCLUSIVE);
+	entry = (SharedConstant*) hash_search(sharedConstants, &key, HASH_FIND,
+			NULL);
+	if (entry != NULL)
+	{
+		oldContent = entry->sharedContent;
+		hash_search(sharedConstants, &key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(sharedConstantsLock);
 
-	PG_RETURN_BOOL(true);
+	if (DsaPointerIsValid(oldContent))
+	{
+		dsa_free(getSharedConstantsArea(), oldContent);
+	}
 }
 
 /*
- * get(variable_constant_name text) returns anyelement
+ * Lets a constant that is being loaded use the shared value if that was
+ * published from the same version of the catalog row, so the value needs
+ * neither to be deserialized nor to be copied into the session.
+ *
+ * @param SessionVariable* variable - The constant, still null
+ * @param Timestamp lastUpdated - last_updated_timestamp of the catalog row
+ * @return bool - true if the constant now reads the shared value
  */
-PG_FUNCTION_INFO_V1(get);
-PGDLLEXPORT Datum get( PG_FUNCTION_ARGS)
+bool useSharedConstant(SessionVariable* variable, Timestamp lastUpdated)
 {
-	char* variableName = NULL;
-	Datum result = (Datum) NULL;
-	SessionVariable* variable;
-	bool found;
-	Oid resultTypeOid;
-	bool castFailed;
-	CoercionPathType coercionPathType;
-	Oid coercionFunctionOid;
+	SharedConstantKey key;
+	SharedConstant* entry;
 
-	if (virgin)
+	if (sharedConstants == NULL
+			|| variable->nameLength >= SHARED_CONSTANT_NAME_LENGTH)
 	{
-		reload();
+		return false;
 	}
 
-	if (PG_NARGS() != 2)
+	key = sharedConstantKey(variable->name);
+	LWLockAcquire(sharedConstantsLock, LW_SHARED);
+	entry = (SharedConstant*) hash_search(sharedConstants, &key, HASH_FIND,
+			NULL);
+	if (entry != NULL && entry->type == variable->type
+			&& entry->lastUpdated == lastUpdated)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.get(variable_or_constant_name text, just_for_type anyelement)"))));
-		PG_RETURN_NULL()
-		;
+		variable->isShared = true;
+		variable->isNull = false;
 	}
+	LWLockRelease(sharedConstantsLock);
 
-	if (PG_ARGISNULL(0))
+	return variable->isShared;
+}
+
+/*
+ * Publishes the session local content of a constant in the shared constants
+ * when the current transaction commits, so other sessions never read a value
+ * that is rolled back. A null constant is removed from the shared constants
+ * then. Does nothing for variables.
+ *
+ * @param SessionVariable* variable - The variable or constant
+ * @param Timestamp lastUpdated - last_updated_timestamp of the catalog row, 0
+ *                                if unknown
+ */
+void shareContent(SessionVariable* variable, Timestamp lastUpdated)
+{
+	if (sharedConstants == NULL || !variable->isConstant)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+		return;
 	}
 
-	variableName = text_to_cstring(PG_GETARG_TEXT_P(0));
+	queueSharedConstantChange(variable->name, variable->isNull, lastUpdated);
+}
 
-	elog(DEBUG1, "@>get('%s')", variableName);
+/*
+ * Remembers a change of a shared constant, to be applied when the current
+ * transaction commits and to be forgotten when the (sub)transaction in which
+ * it was made is rolled back
+ *
+ * @param char* constantName - The name of the constant
+ * @param bool isRemoval - true to remove the constant from the shared
+ *                         constants, false to publish its session local value
+ * @param Timestamp lastUpdated - last_updated_timestamp of the catalog row, 0
+ *                                if unknown
+ */
+void queueSharedConstantChange(char* constantName, bool isRemoval,
+		Timestamp lastUpdated)
+{
+	SharedConstantChange* change;
 
-	variable = searchVariable(variableName, &variables, &found);
-	if (!found)
+	if (sharedConstants == NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant '%s' does not exists", variableName ))));
-		PG_RETURN_NULL()
-		;
+		return;
 	}
 
-	resultTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 1);
-	if (variable->isNull)
+	if (!sharedConstantsCallbacksRegistered)
 	{
-		if (resultTypeOid == variable->type)
-		{
-			coercionPathType = COERCION_PATH_RELABELTYPE;
-		}
-		else
-		{
-			coercionPathType = find_coercion_pathway(variable->type,
-					resultTypeOid, COERCION_EXPLICIT, &coercionFunctionOid);
-		}
-		switch (coercionPathType)
-		{
-		case COERCION_PATH_RELABELTYPE:
-		case COERCION_PATH_FUNC:
-		case COERCION_PATH_COERCEVIAIO:
-			elog(DEBUG1, "@<get('%s') = NULL", variableName);
-			PG_RETURN_NULL()
-			;
-			break;
-		default:
-			ereport(ERROR,
-					(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("The variable's internal type %s, cannot be cast to type %s", getTypeName(variable->type) ,getTypeName(resultTypeOid) ))));
-			PG_RETURN_NULL()
-			;
-		}
+		RegisterXactCallback(sharedConstantsXactCallback, NULL);
+		RegisterSubXactCallback(sharedConstantsSubXactCallback, NULL);
+		sharedConstantsCallbacksRegistered = true;
 	}
 
-	result = coerceOutput(variable->type, variable->typeLength,
-			variable->content, resultTypeOid, &castFailed);
-
-	elog(DEBUG1, "@<get('%s')", variableName);
-
-	PG_RETURN_DATUM(result);
+	change = (SharedConstantChange*) MemoryContextAlloc(TopTransactionContext,
+			offsetof(SharedConstantChange, name) + strlen(constantName) + 1);
+	strcpy(change->name, constantName);
+	change->subTransactionId = GetCurrentSubTransactionId();
+	change->isRemoval = isRemoval;
+	change->lastUpdated = lastUpdated;
+	change->next = sharedConstantChanges;
+	sharedConstantChanges = change;
 }
 
 /*
- * get_constant(constant_name text) returns anyelement
+ * Applies a change of a shared constant. The value that is published is the
+ * session local value of the constant at commit, if the constant still exists
+ * in the session. If that succeeds, the session local copy is released and the
+ * constant reads the shared value from then on.
+ *
+ * @param SharedConstantChange* change - The change to apply
  */
-PG_FUNCTION_INFO_V1(get_constant);
-PGDLLEXPORT Datum get_constant( PG_FUNCTION_ARGS)
+void applySharedConstantChange(SharedConstantChange* change)
 {
-	char* variableName = NULL;
-	Datum result = (Datum) NULL;
+	SessionVariable* root = variables;
 	SessionVariable* variable;
 	bool found;
-	Oid resultTypeOid;
-	bool castFailed;
-	CoercionPathType coercionPathType;
-	Oid coercionFunctionOid;
 
-	if (virgin)
+	if (change->isRemoval)
 	{
-		reload();
+		unpublishSharedConstant(change->name);
+		return;
 	}
 
-	if (PG_NARGS() != 2)
+	/*
+	 * Searched from a copy of the root, so no bound settings are applied and
+	 * no group is loaded while the transaction commits
+	 */
+	variable = searchVariable(change->name, &root, &found);
+	if (!found || !variable->isConstant || variable->isNull
+			|| variable->isShared)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.get_constant(constant_name text, just_for_type anyelement)"))));
-		PG_RETURN_NULL()
-		;
+		return;
 	}
 
-	if (PG_ARGISNULL(0))
+	if (publishSharedConstant(variable, getContent(variable),
+			change->lastUpdated))
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+		freeContent(variable);
+		variable->content = (Datum) NULL;
+		variable->isShared = true;
 	}
+}
 
-	variableName = text_to_cstring(PG_GETARG_TEXT_P(0));
+/*
+ * Applies the changes of shared constants of a transaction that commits, in
+ * the order in which they were made, and forgets them when it is rolled back.
+ * A prepared transaction does not publish its changes, the constants are
+ * published again by the next session that loads them after the commit.
+ */
+void sharedConstantsXactCallback(XactEvent event, void* arg)
+{
+	SharedConstantChange* change;
+	SharedConstantChange* inOrder = NULL;
 
-	elog(DEBUG1, "@>get_constant('%s')", variableName);
+	switch (event)
+	{
+	case XACT_EVENT_COMMIT:
+		while (sharedConstantChanges != NULL)
+		{
+			change = sharedConstantChanges;
+			sharedConstantChanges = change->next;
+			change->next = inOrder;
+			inOrder = change;
+		}
+		for (change = inOrder; change != NULL; change = change->next)
+		{
+			applySharedConstantChange(change);
+		}
+		break;
+	case XACT_EVENT_ABORT:
+	case XACT_EVENT_PREPARE:
+		/*
+		 * The changes themselves are in TopTransactionContext
+		 */
+		sharedConstantChanges = NULL;
+		break;
+	default:
+		break;
+	}
+}
 
-	variable = searchVariable(variableName, &variables, &found);
-	if (!found)
+/*
+ * Forgets the changes of shared constants that were made in a subtransaction
+ * that is rolled back, including the ones of its committed subtransactions
+ */
+void sharedConstantsSubXactCallback(SubXactEvent event,
+		SubTransactionId mySubid, SubTransactionId parentSubid, void* arg)
+{
+	if (event != SUBXACT_EVENT_ABORT_SUB)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NO_DATA),(errmsg("constant '%s' does not exists", variableName ))));
-		PG_RETURN_NULL()
-		;
+		return;
 	}
 
-	if (!variable->isConstant)
+	/*
+	 * The list is newest first and subtransaction ids only grow within a
+	 * transaction
+	 */
+	while (sharedConstantChanges != NULL
+			&& sharedConstantChanges->subTransactionId >= mySubid)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_WRONG_OBJECT_TYPE),(errmsg("'%s' is not a constant", variableName ))));
-		PG_RETURN_NULL()
-		;
+		sharedConstantChanges = sharedConstantChanges->next;
 	}
+}
 
-	resultTypeOid = get_fn_expr_argtype(fcinfo->flinfo, 1);
-	if (variable->isNull)
+/*
+ * Reads the value of a shared constant
+ *
+ * @param SessionVariable* variable - A constant with isShared set
+ * @return Datum - The value, palloced if it is not passed by value
+ */
+Datum readSharedConstant(SessionVariable* variable)
+{
+	SharedConstantKey key;
+	SharedConstant* entry;
+	dsa_area* area = getSharedConstantsArea();
+	Datum result = (Datum) NULL;
+	bool found = false;
+
+	key = sharedConstantKey(variable->name);
+	LWLockAcquire(sharedConstantsLock, LW_SHARED);
+	entry = (SharedConstant*) hash_search(sharedConstants, &key, HASH_FIND,
+			NULL);
+	if (entry != NULL && entry->type == variable->type)
 	{
-		if (resultTypeOid == variable->type)
+		if (DsaPointerIsValid(entry->sharedContent))
 		{
-			coercionPathType = COERCION_PATH_RELABELTYPE;
+			result = PointerGetDatum(palloc(entry->contentSize));
+			memcpy(DatumGetPointer(result),
+					dsa_get_address(area, entry->sharedContent),
+					entry->contentSize);
 		}
 		else
 		{
-			coercionPathType = find_coercion_pathway(variable->type,
-					resultTypeOid, COERCION_EXPLICIT, &coercionFunctionOid);
-		}
-		switch (coercionPathType)
-		{
-		case COERCION_PATH_RELABELTYPE:
-		case COERCION_PATH_FUNC:
-		case COERCION_PATH_COERCEVIAIO:
-			elog(DEBUG1, "@<get('%s') = NULL", variableName);
-			PG_RETURN_NULL()
-			;
-			break;
-		default:
-			ereport(ERROR,
-					(errcode(ERRCODE_INVALID_PARAMETER_VALUE), (errmsg("The constant's internal type %s, cannot be cast to type %s", getTypeName(variable->type) ,getTypeName(resultTypeOid) ))));
-			PG_RETURN_NULL()
-			;
+			result = entry->content;
 		}
+		found = true;
 	}
+	LWLockRelease(sharedConstantsLock);
 
-	result = coerceOutput(variable->type, variable->typeLength,
-			variable->content, resultTypeOid, &castFailed);
-
-	elog(DEBUG1, "@<get_constant('%s')", variableName);
-
-	PG_RETURN_DATUM(result);
+	if (!found)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE), (errmsg("constant \"%s\" has been dropped or altered to null in another session", variable->name)), (errhint("Execute session_variable.init() to reload the variables and constants"))));
+	}
+	return result;
 }
 
 /*
- * type_of(variable_or_constant_name text) returns regtype
+ * Returns the version of a variable: the modification sequence number of its
+ * last change in the current session, as in changes_since(), plus, for a
+ * shared constant, the version of its published value. So the version of a
+ * shared constant also grows when another session alters it.
+ *
+ * @param SessionVariable* variable - The variable or constant
+ * @return uint64 - Its version
  */
-PG_FUNCTION_INFO_V1(type_of);
-PGDLLEXPORT Datum type_of( PG_FUNCTION_ARGS)
+uint64 variableVersion(SessionVariable* variable)
 {
-	char* variableName = NULL;
-	SessionVariable* variable;
-	bool found;
+	SharedConstantKey key;
+	SharedConstant* entry;
+	uint64 version = variable->modification;
 
-	if (virgin)
+	if (!variable->isShared)
 	{
-		reload();
+		return version;
 	}
 
-	if (PG_NARGS() != 1)
+	key = sharedConstantKey(variable->name);
+	LWLockAcquire(sharedConstantsLock, LW_SHARED);
+	entry = (SharedConstant*) hash_search(sharedConstants, &key, HASH_FIND,
+			NULL);
+	if (entry != NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.type_of(variable_or_constant_name text)"))));
-		PG_RETURN_NULL()
-		;
+		version += entry->version;
 	}
+	LWLockRelease(sharedConstantsLock);
+	return version;
+}
 
-	if (PG_ARGISNULL(0))
+/*
+ * Returns the usage counters of the variable, allocating them on first use.
+ *
+ * @param SessionVariable* variable - The variable
+ * @return VariableUsage* - Its usage counters
+ */
+VariableUsage* getUsage(SessionVariable* variable)
+{
+	if (variable->usage == NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+		/*
+		 * Belongs to the variable, which is malloced as well
+		 */
+		variable->usage = (VariableUsage*) malloc(sizeof(VariableUsage));
+		if (variable->usage == NULL)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY), errmsg("out of memory")));
+		}
+		memset(variable->usage, 0, sizeof(VariableUsage));
 	}
+	return variable->usage;
+}
 
-	variableName = text_to_cstring(PG_GETARG_TEXT_P(0));
+/*
+ * Registers a get of the variable for the shared statistics. Does nothing if
+ * the shared statistics are not enabled.
+ *
+ * @param SessionVariable* variable - The variable that was read
+ * @param CoercionPathType coercionPath - How the content was coerced,
+ *                                        COERCION_PATH_NONE for null
+ * @param Oid resultTypeOid - The type that was returned
+ * @param bool isNull - True if null was returned
+ * @param Datum result - The returned content
+ */
+void countGet(SessionVariable* variable, CoercionPathType coercionPath,
+		Oid resultTypeOid, bool isNull, Datum result)
+{
+	VariableUsage* usage;
+	int resultTypeLength;
 
-	elog(DEBUG1, "@>type_of('%s')", variableName);
+	if (sharedStatistics == NULL)
+	{
+		return;
+	}
 
-	variable = searchVariable(variableName, &variables, &found);
-	if (!found)
+	usage = getUsage(variable);
+	usage->getCalls++;
+	if (isNull)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant '%s' does not exists", variableName ))));
-		PG_RETURN_NULL()
-		;
+		return;
 	}
 
-	elog(DEBUG1, "@<type_of('%s')", variableName);
+	switch (coercionPath)
+	{
+	case COERCION_PATH_RELABELTYPE:
+		usage->relabelCoercions++;
+		break;
+	case COERCION_PATH_FUNC:
+		usage->funcCoercions++;
+		break;
+	case COERCION_PATH_COERCEVIAIO:
+		usage->ioCoercions++;
+		break;
+	default:
+		break;
+	}
 
-	PG_RETURN_OID(variable->type);
+	if (resultTypeOid == variable->type)
+	{
+		resultTypeLength = variable->typeLength;
+	}
+	else
+	{
+		resultTypeLength = get_typlen(resultTypeOid);
+	}
+	if (resultTypeLength == -1)
+	{
+		usage->bytesReturned += VARSIZE_ANY(DatumGetPointer(result));
+	}
+	else if (resultTypeLength == -2)
+	{
+		usage->bytesReturned += strlen(DatumGetCString(result)) + 1;
+	}
+	else
+	{
+		usage->bytesReturned += resultTypeLength;
+	}
 }
 
 /*
- * exists(variable_constant_name text) returns bool
+ * Adds the usage of the variable and its subordinates to the shared
+ * statistics and resets the session local counters. The caller must hold the
+ * sharedStatisticsLock exclusively.
+ *
+ * @param SessionVariable* variable - The (sub)tree to flush, may be NULL
  */
-PG_FUNCTION_INFO_V1(exists);
-PGDLLEXPORT Datum exists( PG_FUNCTION_ARGS)
+void flushStatisticsRecursively(SessionVariable* variable)
 {
+	SharedStatisticsKey key;
+	SharedStatisticsEntry* entry;
 	bool found;
-	char* variableName;
 
-	if (virgin)
+	if (variable == NULL)
 	{
-		reload();
+		return;
 	}
 
-	if (PG_NARGS() != 1)
+	if (variable->usage != NULL && variable->usage->getCalls + variable->usage->setCalls > 0)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION), (errmsg( "Usage: session_variable.exists(variable_or_constant_name text)"))));
-		PG_RETURN_NULL()
-		;
-	}
+		memset(&key, 0, sizeof(key));
+		key.databaseOid = MyDatabaseId;
+		strlcpy(key.variableName, variable->name, sizeof(key.variableName));
 
-	if (PG_ARGISNULL(0))
-	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+		entry = (SharedStatisticsEntry*) hash_search(sharedStatistics, &key,
+				HASH_ENTER_NULL, &found);
+		if (entry != NULL)
+		{
+			if (!found)
+			{
+				memset(&entry->usage, 0, sizeof(VariableUsage));
+			}
+			entry->usage.getCalls += variable->usage->getCalls;
+			entry->usage.setCalls += variable->usage->setCalls;
+			entry->usage.relabelCoercions += variable->usage->relabelCoercions;
+			entry->usage.funcCoercions += variable->usage->funcCoercions;
+			entry->usage.ioCoercions += variable->usage->ioCoercions;
+			entry->usage.bytesReturned += variable->usage->bytesReturned;
+		}
+		/*
+		 * If the hash table is full the usage is lost, as in
+		 * pg_stat_statements
+		 */
+		memset(variable->usage, 0, sizeof(VariableUsage));
 	}
 
-	variableName = text_to_cstring((text*) PG_GETARG_TEXT_P(0));
-
-	elog(DEBUG1, "@>exists('%s')", variableName);
+	flushStatisticsRecursively(variable->prior);
+	flushStatisticsRecursively(variable->next);
+}
 
-	searchVariable(variableName, &variables, &found);
+/*
+ * Adds the usage of all variables in the session to the shared statistics.
+ * Does nothing if the shared statistics are not enabled.
+ */
+void flushStatistics(void)
+{
+	if (sharedStatistics == NULL || variables == NULL)
+	{
+		return;
+	}
 
-	elog(DEBUG1, "@<exists('%s') = %d", variableName, found);
+	LWLockAcquire(sharedStatisticsLock, LW_EXCLUSIVE);
+	flushStatisticsRecursively(variables);
+	LWLockRelease(sharedStatisticsLock);
 
-	PG_RETURN_BOOL(found);
+	lastStatisticsFlush = GetCurrentTimestamp();
 }
 
 /*
- * is_constant(variable_constant_name text) returns bool
+ * Flushes the usage into the shared statistics at the end of a transaction if
+ * session_variable.stats_flush_interval has passed since the last flush.
  */
-PG_FUNCTION_INFO_V1(is_constant);
-PGDLLEXPORT Datum is_constant( PG_FUNCTION_ARGS)
+void statisticsXactCallback(XactEvent event, void* arg)
 {
-	char* variableName;
-	SessionVariable* variable;
-	bool found;
-
-	if (virgin)
+	if ((event == XACT_EVENT_COMMIT || event == XACT_EVENT_ABORT)
+			&& TimestampDifferenceExceeds(lastStatisticsFlush,
+					GetCurrentTimestamp(),
+					sharedStatisticsFlushInterval * 1000))
 	{
-		reload();
+		flushStatistics();
 	}
+}
 
-	if (PG_NARGS() != 1)
+/*
+ * Flushes the usage into the shared statistics when the session ends.
+ */
+void statisticsShmemExit(int code, Datum arg)
+{
+	flushStatistics();
+}
+
+/*
+ * function session_variable.stats() returns setof record
+ *
+ * Returns the usage of the variables, aggregated over all sessions since the
+ * last stats_reset(). The usage of the current session is flushed first.
+ */
+PG_FUNCTION_INFO_V1(stats);
+PGDLLEXPORT Datum stats( PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo* rsinfo = (ReturnSetInfo*) fcinfo->resultinfo;
+	TupleDesc tupleDesc;
+	Tuplestorestate* tupleStore;
+	MemoryContext oldContext;
+	HASH_SEQ_STATUS hashSeq;
+	SharedStatisticsEntry* entry;
+	Datum values[8];
+	bool nulls[8];
+
+	if (sharedStatistics == NULL)
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.exists(variable_or_constant_name text)"))));
-		PG_RETURN_NULL()
-		;
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE), (errmsg("session_variable must be loaded via shared_preload_libraries to keep shared statistics"))));
 	}
 
-	if (PG_ARGISNULL(0))
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo)
+			|| !(rsinfo->allowedModes & SFRM_Materialize))
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED), (errmsg("variable or constant name must be filled"))));
-		PG_RETURN_NULL()
-		;
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), (errmsg("set-valued function called in context that cannot accept a set"))));
+	}
+	if (get_call_result_type(fcinfo, NULL, &tupleDesc) != TYPEFUNC_COMPOSITE)
+	{
+		elog(ERROR, "return type must be a row type");
 	}
 
-	variableName = text_to_cstring((text*) PG_GETARG_TEXT_P(0));
+	oldContext = MemoryContextSwitchTo(
+			rsinfo->econtext->ecxt_per_query_memory);
+	tupleStore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupleStore;
+	rsinfo->setDesc = tupleDesc;
+	MemoryContextSwitchTo(oldContext);
 
-	elog(DEBUG1, "@>is_constant('%s')", variableName);
+	flushStatistics();
 
-	variable = searchVariable(variableName, &variables, &found);
-	if (!found)
+	memset(nulls, 0, sizeof(nulls));
+	LWLockAcquire(sharedStatisticsLock, LW_SHARED);
+	hash_seq_init(&hashSeq, sharedStatistics);
+	while ((entry = (SharedStatisticsEntry*) hash_seq_search(&hashSeq)) != NULL)
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_NO_DATA),(errmsg("variable or constant '%s' does not exists", variableName ))));
-		PG_RETURN_NULL()
-		;
+		values[0] = ObjectIdGetDatum(entry->key.databaseOid);
+		values[1] = CStringGetTextDatum(entry->key.variableName);
+		values[2] = Int64GetDatum(entry->usage.getCalls);
+		values[3] = Int64GetDatum(entry->usage.setCalls);
+		values[4] = Int64GetDatum(entry->usage.relabelCoercions);
+		values[5] = Int64GetDatum(entry->usage.funcCoercions);
+		values[6] = Int64GetDatum(entry->usage.ioCoercions);
+		values[7] = Int64GetDatum(entry->usage.bytesReturned);
+		tuplestore_putvalues(tupleStore, tupleDesc, values, nulls);
 	}
+	LWLockRelease(sharedStatisticsLock);
 
-	elog(DEBUG1, "@<is_constant('%s') = %d", variableName,
-	variable->isConstant);
-
-	PG_RETURN_BOOL(variable->isConstant);
+	return (Datum) 0;
 }
 
 /*
- * init() returns integer
+ * function session_variable.stats_reset() returns void
+ *
+ * Clears the shared statistics.
  */
-PG_FUNCTION_INFO_V1(init);
-PGDLLEXPORT Datum init( PG_FUNCTION_ARGS)
+PG_FUNCTION_INFO_V1(stats_reset);
+PGDLLEXPORT Datum stats_reset( PG_FUNCTION_ARGS)
 {
-	int result;
+	HASH_SEQ_STATUS hashSeq;
+	SharedStatisticsEntry* entry;
 
-	if (PG_NARGS() != 0)
+	if (sharedStatistics == NULL)
 	{
 		ereport(ERROR,
-				(errcode(ERRCODE_UNDEFINED_FUNCTION),(errmsg( "Usage: session_variable.init()"))));
-		PG_RETURN_INT32(-1);
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE), (errmsg("session_variable must be loaded via shared_preload_libraries to keep shared statistics"))));
 	}
 
-	elog(DEBUG1, "@>init()");
-
-	result = reload();
-
-	elog(DEBUG1, "@<init() = %d", result);
+	LWLockAcquire(sharedStatisticsLock, LW_EXCLUSIVE);
+	hash_seq_init(&hashSeq, sharedStatistics);
+	while ((entry = (SharedStatisticsEntry*) hash_seq_search(&hashSeq)) != NULL)
+	{
+		hash_search(sharedStatistics, &entry->key, HASH_REMOVE, NULL);
+	}
+	LWLockRelease(sharedStatisticsLock);
 
-	PG_RETURN_INT32(result);
+	PG_RETURN_VOID();
 }
 
 /*
@@ -18,7 +18,7 @@
 #ifndef SESSION_VARIABLE_H
 #define SESSION_VARIABLE_H
 
-static char* sessionVariableVersion = "3.4";
+static char* sessionVariableVersion = "3.5";
 
 /*
  * Loads the session variables from the session_variable.variables table
@@ -29,31 +29,396 @@ void _PG_init(void);
  * Functions defined in this file
  */
 extern PGDLLEXPORT Datum alter_value( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum backend_stats( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum catalog_changed( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum changes_since( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum create_constant( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum create_variable( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum current_values( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum drop( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum exists( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum export_state( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum get( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum get_bool( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum get_constant( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum get_int4( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum get_int8( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum get_session_variable_version( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum get_stable_support( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum get_text( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum get_timestamptz( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum get_uuid( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum import( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum import_state( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum init( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum init_worker( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum is_constant( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum is_executing_variable_initialisation( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum rows( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum rows_support( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum set( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum set_bool( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum set_int4( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum set_int8( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum set_rows( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum set_text( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum set_timestamptz( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum set_uuid( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum stats( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum stats_reset( PG_FUNCTION_ARGS);
 extern PGDLLEXPORT Datum type_of( PG_FUNCTION_ARGS);
+extern PGDLLEXPORT Datum version( PG_FUNCTION_ARGS);
 
+/*
+ * Usage of a single variable, kept only when the shared statistics are
+ * enabled, see flushStatistics()
+ */
+typedef struct VariableUsage
+{
+	int64 getCalls;
+	int64 setCalls;
+	int64 relabelCoercions;
+	int64 funcCoercions;
+	int64 ioCoercions;
+	int64 bytesReturned;
+} VariableUsage;
+
+/*
+ * A variable is a single malloced block: this struct with the name behind it
+ * and, for by-reference types, room for a value of up to INLINE_CONTENT_SIZE
+ * bytes behind the name. Larger values are malloced separately.
+ */
 typedef struct SessionVariable
 {
 	struct SessionVariable* prior;
 	struct SessionVariable* next;
-	char *name;
-	Oid type;
 	Datum content;
-	bool isConstant;
+	VariableUsage* usage;
+	Oid type;
 	int typeLength;
+	int nameLength;
+	bool isConstant;
 	bool isNull;
+	bool isShared; /* content is read from the shared constants */
+	bool isModified; /* set() since the variable was loaded */
+	bool isTransactionScoped; /* reset at the end of each transaction */
+	uint64 modification; /* the state version of the last change */
+	char name[FLEXIBLE_ARRAY_MEMBER];
 } SessionVariable;
 
+/*
+ * Values of by-reference types up to this size are stored inline
+ */
+#define INLINE_CONTENT_SIZE 64
+
+/*
+ * The room for an inline value that is reserved for a type of length
+ * typeLength, 0 if values of the type are never stored inline
+ */
+#define inlineContentSize(typeLength) \
+	((typeLength) < 0 ? INLINE_CONTENT_SIZE \
+	 : ((typeLength) > SIZEOF_DATUM && (typeLength) <= INLINE_CONTENT_SIZE) ? (typeLength) : 0)
+
+/*
+ * The start of the inline value of a variable, behind its name
+ */
+#define inlineContent(variable) \
+	((char*) (variable) + MAXALIGN(offsetof(SessionVariable, name) + (variable)->nameLength + 1))
+
+/*
+ * Names longer than this are truncated in the shared statistics
+ */
+#define SHARED_STATISTICS_NAME_LENGTH 128
+
+typedef struct SharedStatisticsKey
+{
+	Oid databaseOid;
+	char variableName[SHARED_STATISTICS_NAME_LENGTH];
+} SharedStatisticsKey;
+
+/*
+ * Usage of a variable, aggregated over all sessions in shared memory
+ */
+typedef struct SharedStatisticsEntry
+{
+	SharedStatisticsKey key;
+	VariableUsage usage;
+} SharedStatisticsEntry;
+
+/*
+ * Constants with longer names are not kept in the shared constants
+ */
+#define SHARED_CONSTANT_NAME_LENGTH 128
+
+typedef struct SharedConstantKey
+{
+	Oid databaseOid;
+	char constantName[SHARED_CONSTANT_NAME_LENGTH];
+} SharedConstantKey;
+
+/*
+ * The value of a constant in shared memory. Values that are passed by value
+ * are kept in content, other values in the dsa area of the shared constants.
+ */
+typedef struct SharedConstant
+{
+	SharedConstantKey key;
+	Oid type;
+	int typeLength;
+	Timestamp lastUpdated; /* of the catalog row, 0 if unknown */
+	uint64 version;
+	Datum content;
+	dsa_pointer sharedContent;
+	Size contentSize;
+} SharedConstant;
+
+/*
+ * Fixed part of the shared constants in the main shared memory segment
+ */
+typedef struct SharedConstantsControl
+{
+	int trancheId;
+	dsa_handle area;
+	uint64 version;
+} SharedConstantsControl;
+
+/*
+ * A change of a shared constant by the current transaction, that is applied
+ * to the shared constants when the transaction commits, see
+ * queueSharedConstantChange()
+ */
+typedef struct SharedConstantChange
+{
+	struct SharedConstantChange* next;
+	SubTransactionId subTransactionId;
+	bool isRemoval;
+	Timestamp lastUpdated; /* of the catalog row, 0 if unknown */
+	char name[FLEXIBLE_ARRAY_MEMBER];
+} SharedConstantChange;
+
+/*
+ * The catalog of session_variable.preload_database as loaded by the preload
+ * worker, in the format of serializeVariables() preceded by the number of
+ * variables. The image is up to date if imageGeneration equals generation.
+ */
+typedef struct PreloadedCatalog
+{
+	int trancheId;
+	dsa_handle area;
+	Oid databaseOid; /* of the preload worker */
+	struct Latch* workerLatch;
+	uint64 generation; /* raised by every committed change of the catalog */
+	uint64 imageGeneration; /* generation that image was loaded at */
+	bool isLoaded;
+	dsa_pointer image; /* InvalidDsaPointer if the catalog is not usable */
+	Size imageSize;
+} PreloadedCatalog;
+
+/*
+ * Usage counters of the current session, see backend_stats()
+ */
+typedef struct SessionVariableStatistics
+{
+	int64 getCalls;
+	int64 setCalls;
+	int64 existsCalls;
+	int64 reloadCalls;
+	int64 reloadTotalTime; /* microseconds */
+	int64 reloadMaxTime; /* microseconds */
+	int64 relabelCoercions;
+	int64 funcCoercions;
+	int64 ioCoercions;
+	int64 coercionCacheHits;
+	int64 preloadedReloads;
+} SessionVariableStatistics;
+
+/*
+ * Values of session_variable.compression
+ */
+typedef enum ValueCompression
+{
+	VALUE_COMPRESSION_PGLZ,
+	VALUE_COMPRESSION_LZ4
+} ValueCompression;
+
+/*
+ * Number of decompressed values that are kept per session
+ */
+#define DECOMPRESSION_CACHE_SIZE 4
+
+/*
+ * A decompressed copy of the compressed content of a variable
+ */
+typedef struct DecompressedValue
+{
+	SessionVariable* variable;
+	struct varlena* value;
+} DecompressedValue;
+
+/*
+ * Number of values read as another type than the type of their variable that
+ * are kept per session, see getCoercedValue()
+ */
+#define COERCION_CACHE_SIZE 64
+
+typedef struct CoercedValue
+{
+	SessionVariable* variable;
+	uint64 modification; /* of the variable when it was converted */
+	Oid type;
+	int16 typeLength;
+	bool typeByValue;
+	CoercionPathType coercionPath;
+	Datum value; /* in coercionContext if passed by reference */
+} CoercedValue;
+
+/*
+ * The settings that the conversions of the coerced values depend on, as they
+ * were when the values were converted, see coercionSettingsChanged()
+ */
+typedef struct CoercionSettings
+{
+	int dateStyle;
+	int dateOrder;
+	int intervalStyle;
+	int extraFloatDigits;
+	int byteaOutput;
+	pg_tz* timeZone;
+	char* lcNumeric; /* in TopMemoryContext */
+	char* lcMonetary; /* in TopMemoryContext */
+} CoercionSettings;
+
+/*
+ * A variable in session_variable.parallel_state, followed by its name and, if
+ * its content is passed by reference, contentSize bytes of content
+ */
+typedef struct ParallelStateVariable
+{
+	Oid type;
+	int nameLength;
+	bool isConstant;
+	bool isNull;
+	bool isTransactionScoped;
+	Datum content; /* if passed by value */
+	Size contentSize; /* 0 if passed by value */
+} ParallelStateVariable;
+
+/*
+ * A group of variables that has been loaded, see loadGroup()
+ */
+typedef struct LoadedGroup
+{
+	struct LoadedGroup* next;
+	int prefixLength;
+	char prefix[FLEXIBLE_ARRAY_MEMBER]; /* group name including the dot */
+} LoadedGroup;
+
+/*
+ * The writes to the session_variable.variables table that can be deferred
+ */
+typedef enum PendingWriteType
+{
+	PENDING_INSERT,
+	PENDING_UPDATE,
+	PENDING_DELETE
+} PendingWriteType;
+
+/*
+ * The coalesced writes of a variable that are executed at commit, see
+ * deferWrite()
+ */
+typedef struct PendingWrite
+{
+	char* variableName; /* hash key */
+	bool deleteRow;
+	bool insertRow;
+	bool updateRow;
+	bool isConstant;
+	bool isTransactionScoped;
+	Oid type;
+	bool isNull;
+	Datum value; /* serialized initial value */
+	SubTransactionId subTransactionId; /* of the last change */
+	struct PendingWrite* saved; /* the writes before that subtransaction, NULL
+	                               if there were none */
+} PendingWrite;
+
+/*
+ * The value of a transaction scoped variable before the current transaction
+ * changed it, to which it is reset when the transaction ends, see
+ * rememberTransactionScopedValue()
+ */
+typedef struct TransactionScopedValue
+{
+	struct TransactionScopedValue* next;
+	SessionVariable* variable;
+	bool isModified;
+	bool isNull;
+	Datum value; /* in TopTransactionContext if passed by reference */
+} TransactionScopedValue;
+
+/*
+ * The rows of a result set variable, see set_rows(). The rows are kept in a
+ * tuple store that spills to a temporary file beyond work_mem.
+ */
+typedef struct RowSet
+{
+	struct RowSet* next;
+	MemoryContext context; /* holds the row set, its tuple store and tuple descriptor */
+	Tuplestorestate* rows;
+	TupleDesc tupleDesc;
+	int64 rowCount;
+	char name[FLEXIBLE_ARRAY_MEMBER];
+} RowSet;
+
+/*
+ * A variable that is bound to setting session_variable.<variableName>, see
+ * applyBoundSettings()
+ */
+typedef struct BoundSetting
+{
+	char* variableName;
+	char* value; /* maintained by the GUC mechanism */
+	char* appliedValue; /* the value the variable has last been set to */
+} BoundSetting;
+
+/*
+ * A validated row of import()
+ */
+typedef struct ImportDefinition
+{
+	char* name;
+	Oid type;
+	bool isConstant;
+	bool isNull;
+	Datum value;
+} ImportDefinition;
+
+/*
+ * The format of the state of export_state(). It is written in network byte
+ * order as:
+ *   int32 EXPORTED_STATE_FORMAT
+ *   Oid the database
+ * followed, for every variable, by:
+ *   int32 length of the name, the name
+ *   Oid the type of the variable
+ *   byte isModified
+ *   int32 length of the value, -1 for null, the value in binary (typsend) format
+ * and ended by a name length of 0.
+ */
+#define EXPORTED_STATE_FORMAT 1
+
+/*
+ * A validated value of import_state()
+ */
+typedef struct ExportedValue
+{
+	SessionVariable* variable;
+	bool isModified;
+	bool isNull;
+	Datum value;
+} ExportedValue;
+
 #define getTypeName(typeOid) (DatumGetCString(DirectFunctionCall1(regtypeout, typeOid)))
 
 #endif   /* SESSION_VARIABLE_H */
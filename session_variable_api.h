@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+
+/*
+ * C interface of session_variable for other extensions.
+ *
+ * The session_variable library publishes a SessionVariableApi in the
+ * rendezvous variable SESSION_VARIABLE_API_NAME when it is loaded:
+ *
+ *     SessionVariableApi* api = *(SessionVariableApi**)
+ *             find_rendezvous_variable(SESSION_VARIABLE_API_NAME);
+ *
+ * api is NULL if the library is not loaded (yet), load it with
+ * load_file("session_variable", false) or via shared_preload_libraries.
+ * Check api->version before using functions that were added later.
+ *
+ * The functions do the same as their SQL counterparts, but without the
+ * function manager, the security definer switch and the text argument. They
+ * do not check privileges and must be invoked in a transaction, because the
+ * variables are loaded from the session_variable.variables table when they are
+ * used first.
+ */
+
+#ifndef SESSION_VARIABLE_API_H
+#define SESSION_VARIABLE_API_H
+
+#define SESSION_VARIABLE_API_NAME "session_variable_api"
+#define SESSION_VARIABLE_API_VERSION 2
+
+/*
+ * A variable or constant that has been looked up by name. The handle stays
+ * valid when the variables are reloaded, and even when the variable is dropped
+ * and created again, it then finds the variable again by name.
+ */
+typedef struct SessionVariableHandle
+{
+	void* variable; /* internal */
+	uint64 generation; /* internal */
+	char name[FLEXIBLE_ARRAY_MEMBER];
+} SessionVariableHandle;
+
+typedef struct SessionVariableApi
+{
+	/*
+	 * SESSION_VARIABLE_API_VERSION of the library
+	 */
+	int version;
+
+	/*
+	 * Returns a handle for the variable or constant, palloced in the current
+	 * memory context, or NULL if it does not exist
+	 */
+	SessionVariableHandle* (*lookup)(const char* variableName);
+
+	/*
+	 * Sets *value and *isNull to the value of the variable or constant, cast
+	 * to resultType. Returns false if the variable does not exist (anymore).
+	 * A value of a type that is passed by reference is palloced in the
+	 * current memory context.
+	 */
+	bool (*get)(SessionVariableHandle* handle, Oid resultType, Datum* value,
+			bool* isNull);
+	bool (*getByName)(const char* variableName, Oid resultType, Datum* value,
+			bool* isNull);
+
+	/*
+	 * Sets the session local value of the variable to value, that is of type
+	 * valueType. Returns false if the variable does not exist (anymore).
+	 * Raises an error for a constant.
+	 */
+	bool (*set)(SessionVariableHandle* handle, Oid valueType, Datum value,
+			bool isNull);
+	bool (*setByName)(const char* variableName, Oid valueType, Datum value,
+			bool isNull);
+
+	/*
+	 * Returns a number that is raised on every change of a variable in the
+	 * session, including reloads, so a cached value is only to be read again
+	 * if this number has changed
+	 */
+	uint64 (*changeGeneration)(void);
+
+	/*
+	 * Sets *version to the version of the variable or constant, that is
+	 * higher after every change of it in the session, including reloads, and
+	 * for a shared constant also after another session altered it.
+	 * Returns false if the variable does not exist (anymore).
+	 * Since version 2.
+	 */
+	bool (*getVersion)(SessionVariableHandle* handle, uint64* version);
+} SessionVariableApi;
+
+#endif /* SESSION_VARIABLE_API_H */
@@ -0,0 +1,46 @@
+# Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+#
+# This program is free software: You may redistribute and/or modify under the
+# terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at Client's option) any
+# later version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+# details.
+#
+# You should have received a copy of the GNU General Public License along with
+# this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+
+# Other sessions read the value that alter_value() gives a shared constant
+# only after the commit, and never if the transaction is rolled back. The
+# version of the constant changes in the other sessions at the commit as well.
+
+setup
+{
+    create extension session_variable;
+    select session_variable.create_constant('shared_label', 'text'::regtype, 'initial'::text);
+}
+
+teardown
+{
+    drop extension session_variable;
+    drop schema session_variable;
+}
+
+session reader
+step reader_init { select session_variable.init(); }
+step reader_get { select session_variable.get_constant('shared_label', null::text); }
+step reader_remember { select set_config('test.version', session_variable.version('shared_label')::text, false) is not null as remembered; }
+step reader_changed { select session_variable.version('shared_label') <> current_setting('test.version')::bigint as changed; }
+
+session writer
+step writer_begin { begin; }
+step writer_alter { select session_variable.alter_value('shared_label', 'altered'::text); }
+step writer_rollback { rollback; }
+step writer_commit { commit; }
+
+permutation reader_init reader_get writer_begin writer_alter reader_get writer_rollback reader_get
+permutation reader_init reader_get writer_begin writer_alter reader_get writer_commit reader_get
+permutation reader_init reader_remember writer_begin writer_alter reader_changed writer_commit reader_changed
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init, binding is read when the library is loaded
+set session_variable.bound_variables = 'tenant';
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('tenant', 'integer'::regtype, 0);
+select session_variable.get('tenant', null::integer);
+
+-- the setting is written through to the variable
+set session_variable.tenant = '42';
+select session_variable.get('tenant', null::integer);
+
+-- set local is undone at the end of the transaction
+begin;
+set local session_variable.tenant = '7';
+select session_variable.get('tenant', null::integer);
+rollback;
+select session_variable.get('tenant', null::integer);
+
+-- set() still works until the setting changes again
+select session_variable.set('tenant', 43);
+select session_variable.get('tenant', null::integer);
+
+-- resetting the setting restores the initial value
+reset session_variable.tenant;
+select session_variable.get('tenant', null::integer);
+
+-- set local without a session value reverts to the initial value
+begin;
+set local session_variable.tenant = '8';
+select session_variable.get('tenant', null::integer);
+commit;
+select session_variable.get('tenant', null::integer);
+
+-- an invalid value is reported when the variable is used
+set session_variable.tenant = 'x';
+select session_variable.get('tenant', null::integer);
+
+-- cleanup
+reset session_variable.tenant;
+drop schema if exists session_variable cascade;
@@ -40,6 +40,7 @@ select session_variable.create_variable('r', 'text'::regtype, 'r'::text);
 select session_variable.create_variable('s', 'text'::regtype, 's'::text);
 select session_variable.create_variable('t', 'text'::regtype, 't'::text);
 select session_variable.create_variable('u', 'text'::regtype, 'u'::text);
+select tree_depth from session_variable.backend_stats();                    -- created in sorted order, yet no list
 
 select session_variable.init();
 
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('a number', 'integer'::regtype, 1);
+select session_variable.create_variable('a text', 'text'::regtype, 'hello'::text);
+select session_variable.create_constant('a constant', 'numeric'::regtype, 2.5);
+
+-- everything is reported after a reload
+select session_variable.init();
+select variable_name, variable_type, is_constant, value_text
+from session_variable.changes_since(0);
+select max(modification_sequence) as synced
+from session_variable.changes_since(0) \gset
+
+-- nothing has changed since
+select variable_name, value_text
+from session_variable.changes_since(:synced);
+
+-- only the changed variable is reported, with a higher sequence number
+select session_variable.set('a number', 2);
+select variable_name, value_text, modification_sequence > :synced as is_later
+from session_variable.changes_since(:synced);
+
+-- a new variable is a change
+select session_variable.create_variable('b number', 'integer'::regtype, 3);
+select variable_name, value_text
+from session_variable.changes_since(:synced);
+
+-- cleanup
+drop schema if exists session_variable cascade;
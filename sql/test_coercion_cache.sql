@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('a bigint', 'bigint'::regtype, 12::bigint);
+select io_coercions as io, func_coercions as func, coercion_cache_hits as hits
+from session_variable.backend_stats() \gset
+
+-- the conversion via text is done once
+select session_variable.get('a bigint', null::text);
+select session_variable.get('a bigint', null::text);
+select io_coercions - :io as conversions, coercion_cache_hits - :hits as cache_hits
+from session_variable.backend_stats();
+
+-- set() invalidates the converted value
+select session_variable.set('a bigint', 34::bigint);
+select session_variable.get('a bigint', null::text);
+select io_coercions - :io as conversions, coercion_cache_hits - :hits as cache_hits
+from session_variable.backend_stats();
+
+-- each type has its own converted value
+select session_variable.get('a bigint', null::integer);
+select session_variable.get('a bigint', null::integer);
+select session_variable.get('a bigint', null::text);
+select func_coercions - :func as conversions, coercion_cache_hits - :hits as cache_hits
+from session_variable.backend_stats();
+
+-- a change of a setting that the conversion depends on invalidates it
+select session_variable.create_variable('a date', 'date'::regtype, '2024-03-01'::date);
+set datestyle = 'ISO, YMD';
+select session_variable.get('a date', null::text);
+set datestyle = 'German';
+select session_variable.get('a date', null::text);
+reset datestyle;
+
+-- a conversion that depends on the search_path is not kept
+create schema coercion_test;
+create table coercion_test.tab (id integer);
+select session_variable.create_variable('a regclass', 'regclass'::regtype, 'coercion_test.tab'::regclass);
+select session_variable.get('a regclass', null::text);
+set search_path = coercion_test, public;
+select session_variable.get('a regclass', null::text);
+reset search_path;
+
+-- cleanup
+drop schema if exists session_variable cascade;
+drop schema coercion_test cascade;
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+
+
+-- init
+create extension session_variable;
+set session_variable.compression_threshold = 1024;
+select session_variable.init();
+
+select session_variable.create_variable('large text', 'text'::regtype, repeat('abcdefghij', 10000));
+select session_variable.create_variable('small text', 'text'::regtype, 'small'::text);
+select session_variable.create_variable('large array', 'int[]'::regtype, array_fill(7, array[10000]));
+
+-- values are compressed, but read back unchanged
+select value_bytes < 10000 from session_variable.backend_stats();
+select length(session_variable.get('large text', null::text));
+select session_variable.get('large text', null::text) = repeat('abcdefghij', 10000);
+select session_variable.get('large text', null::text) = repeat('abcdefghij', 10000);        -- from the decompression cache
+select session_variable.get('small text', null::text);
+select session_variable.get('large array', null::int[]) = array_fill(7, array[10000]);
+
+select session_variable.set('large text', repeat('0123456789', 20000));
+select session_variable.get('large text', null::text) = repeat('0123456789', 20000);
+select session_variable.set('large text', 'no longer large'::text);
+select session_variable.get('large text', null::text);
+
+select session_variable.alter_value('large text', repeat('klmnopqrst', 10000));
+select session_variable.init();
+select value_bytes < 10000 from session_variable.backend_stats();
+select session_variable.get('large text', null::text) = repeat('klmnopqrst', 10000);
+
+-- without compression
+set session_variable.compression_threshold = -1;
+select session_variable.init();
+select value_bytes > 100000 from session_variable.backend_stats();
+select session_variable.get('large text', null::text) = repeat('klmnopqrst', 10000);
+
+-- cleanup
+drop schema if exists session_variable cascade;
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('a number', 'integer'::regtype, 1);
+select session_variable.create_variable('a text', 'text'::regtype, 'hello'::text);
+select session_variable.create_variable('a null', 'date'::regtype);
+select session_variable.create_constant('a constant', 'numeric'::regtype, 2.5);
+select session_variable.set('a text', 'goodbye'::text);
+
+-- all variables and constants in one call
+select variable_name, variable_type, is_constant, is_modified, value_bytes, value_text
+from session_variable.current_values();
+
+-- without the conversion to text
+select variable_name, value_bytes, value_text is null as no_text
+from session_variable.current_values(false);
+
+-- init() reverts the modifications
+select session_variable.init();
+select count(*) from session_variable.current_values() where is_modified;
+
+-- cleanup
+drop schema if exists session_variable cascade;
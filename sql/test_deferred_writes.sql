@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+create table write_log (operation text, variable_name text);
+create function log_write() returns trigger language plpgsql as $$
+begin
+    insert into write_log values (tg_op, coalesce(new.variable_name, old.variable_name));
+    return null;
+end;
+$$;
+create trigger log_write after insert or update or delete on session_variable.variables
+for each row execute procedure log_write();
+
+select session_variable.create_constant('version', 'integer'::regtype, 1);
+select session_variable.create_variable('dropped', 'text'::regtype, 'x'::text);
+truncate write_log;
+
+-- the writes of a variable are coalesced into one write at commit
+begin;
+set local session_variable.defer_writes = on;
+select session_variable.alter_value('version', 2);
+select session_variable.alter_value('version', 3);
+select initial_value from session_variable.variables where variable_name = 'version';
+select session_variable.create_variable('temporary', 'text'::regtype, 'x'::text);
+select session_variable.drop('temporary');
+select session_variable.create_variable('kept', 'text'::regtype, 'a'::text);
+select session_variable.alter_value('kept', 'b'::text);
+select session_variable.drop('dropped');
+commit;
+select * from write_log order by variable_name, operation;
+select variable_name, initial_value from session_variable.variables order by variable_name;
+
+-- deferred writes are discarded on rollback
+truncate write_log;
+begin;
+set local session_variable.defer_writes = on;
+select session_variable.alter_value('version', 4);
+rollback;
+select * from write_log;
+select initial_value from session_variable.variables where variable_name = 'version';
+
+-- deferred writes of a subtransaction are discarded when it is rolled back
+truncate write_log;
+begin;
+set local session_variable.defer_writes = on;
+select session_variable.alter_value('version', 5);
+savepoint before_change;
+select session_variable.alter_value('version', 6);
+select session_variable.create_variable('in savepoint', 'text'::regtype, 'x'::text);
+rollback to savepoint before_change;
+commit;
+select * from write_log;
+select initial_value from session_variable.variables where variable_name = 'version';
+select count(*) from session_variable.variables where variable_name = 'in savepoint';
+
+-- deferred writes are written before the table is read
+begin;
+set local session_variable.defer_writes = on;
+select session_variable.create_variable('flushed', 'integer'::regtype, 5);
+select session_variable.init();
+commit;
+select session_variable.get('flushed', null::integer);
+
+-- loading a group in between does not execute the deferred writes
+select session_variable.create_variable('lazy.one', 'integer'::regtype, 1);
+select session_variable.create_variable('other.two', 'integer'::regtype, 2);
+set session_variable.lazy_load_groups = on;
+select session_variable.init();
+truncate write_log;
+begin;
+set local session_variable.defer_writes = on;
+select session_variable.alter_value('lazy.one', 10);
+select session_variable.get('other.two', null::integer);
+select session_variable.alter_value('lazy.one', 11);
+commit;
+select * from write_log;
+select initial_value from session_variable.variables where variable_name = 'lazy.one';
+reset session_variable.lazy_load_groups;
+
+-- cleanup
+drop schema if exists session_variable cascade;
+drop table write_log;
+drop function log_write();
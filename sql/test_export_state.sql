@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('a number', 'integer'::regtype, 1);
+select session_variable.create_variable('a text', 'text'::regtype, 'hello'::text);
+select session_variable.create_variable('a null', 'date'::regtype);
+select session_variable.create_constant('a constant', 'numeric'::regtype, 2.5);
+select session_variable.set('a number', 2);
+select session_variable.set('a text', 'goodbye'::text);
+
+-- export, revert to the initial values and import again
+select session_variable.export_state() as exported_state \gset
+select session_variable.init();
+select session_variable.get('a number', null::integer);
+select session_variable.import_state(:'exported_state');
+select variable_name, is_modified, value_text
+from session_variable.current_values();
+
+-- not exported by export_state()
+select session_variable.import_state('\x00000002'::bytea);
+
+-- nothing is set if one of the variables has changed
+select session_variable.init();
+select session_variable.drop('a text');
+select session_variable.create_variable('a text', 'integer'::regtype, 0);
+select session_variable.import_state(:'exported_state');
+select session_variable.get('a number', null::integer);
+
+-- cleanup
+drop schema if exists session_variable cascade;
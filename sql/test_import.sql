@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('existing', 'integer'::regtype, 1);
+
+-- import creates all variables and constants at once
+select session_variable.import(array[
+    ('imported int', 'integer'::regtype, false, '42'),
+    ('imported text', 'text'::regtype, null, 'some text'),
+    ('imported const', 'numeric'::regtype, true, '3.14'),
+    ('imported null', 'date'::regtype, false, null)
+]::session_variable.variable_definition[]);
+
+select session_variable.get('imported int', null::integer);
+select session_variable.get('imported text', null::text);
+select session_variable.get_constant('imported const', null::numeric);
+select session_variable.is_constant('imported const');
+select session_variable.get('imported null', null::date) is null;
+select nr_variables, tree_depth from session_variable.backend_stats();
+select variable_name, is_constant, variable_type_name, initial_value
+from session_variable.variables
+order by variable_name;
+
+-- nothing is imported if a definition is wrong
+select session_variable.import(array[
+    ('new', 'integer'::regtype, false, '2'),
+    ('existing', 'integer'::regtype, false, '2')
+]::session_variable.variable_definition[]);
+select session_variable.import(array[
+    ('new', 'text'::regtype, false, 'a'),
+    ('new', 'text'::regtype, false, 'b')
+]::session_variable.variable_definition[]);
+select session_variable.import(array[
+    ('new', 'integer'::regtype, false, 'abc')
+]::session_variable.variable_definition[]);
+select session_variable.import(array[
+    ('', 'text'::regtype, false, null)
+]::session_variable.variable_definition[]);
+select session_variable.exists('new');
+select count(*) from session_variable.variables;
+
+-- the imported variables are loaded by a new session as well
+select session_variable.init();
+select session_variable.get('imported text', null::text);
+
+-- cleanup
+drop schema if exists session_variable cascade;
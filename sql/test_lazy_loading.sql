@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.import(array[
+    ('plain', 'integer'::regtype, false, '1'),
+    ('billing.rate', 'numeric'::regtype, false, '0.21'),
+    ('billing.currency', 'text'::regtype, true, 'EUR'),
+    ('hr.department', 'text'::regtype, false, 'sales'),
+    ('ui.theme', 'text'::regtype, false, 'dark')
+]::session_variable.variable_definition[]);
+
+-- only the variables without a group are loaded at first
+set session_variable.lazy_load_groups = on;
+select session_variable.init();
+select nr_variables from session_variable.backend_stats();
+
+-- a group is loaded when one of its variables is used first
+select session_variable.get('billing.rate', null::numeric);
+select nr_variables from session_variable.backend_stats();
+select session_variable.get_constant('billing.currency', null::text);
+select session_variable.exists('hr.unknown');
+select nr_variables from session_variable.backend_stats();
+select session_variable.exists('nogroup.unknown');
+
+-- init() reloads the groups that were loaded already
+select session_variable.set('billing.rate', 0.09);
+select session_variable.init();
+select session_variable.get('billing.rate', null::numeric);
+
+-- the group is loaded before a variable is added to it
+select session_variable.create_variable('ui.font', 'text'::regtype, 'sans'::text);
+select nr_variables from session_variable.backend_stats();
+select session_variable.get('ui.theme', null::text);
+
+-- everything is loaded when lazy loading is off
+reset session_variable.lazy_load_groups;
+select session_variable.init();
+
+-- a variable of a group that has not been loaded can be dropped
+set session_variable.lazy_load_groups = on;
+select session_variable.init();
+select session_variable.drop('hr.department');
+select nr_variables from session_variable.backend_stats();
+select session_variable.exists('hr.department');
+reset session_variable.lazy_load_groups;
+
+-- cleanup
+drop schema if exists session_variable cascade;
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('timeout', 'integer'::regtype, 10);
+select session_variable.create_variable('colour', 'text'::regtype, 'red'::text);
+select session_variable.create_constant('limit', 'integer'::regtype, 100);
+
+insert into session_variable.variable_overrides (variable_name, role_name, application_name, initial_value)
+values ('timeout', session_user, null, '20')
+     , ('timeout', session_user, 'reporting', '30')
+     , ('timeout', null, 'reporting', '40')
+     , ('colour', null, 'reporting', 'blue')
+     , ('limit', 'nobody', null, '1');
+
+-- the most specific override of the session applies
+select session_variable.init();
+select session_variable.get('timeout', null::integer);
+select session_variable.get('colour', null::text);
+select session_variable.get_constant('limit', null::integer);
+set application_name = 'reporting';
+select session_variable.init();
+select session_variable.get('timeout', null::integer);
+select session_variable.get('colour', null::text);
+reset application_name;
+select session_variable.init();
+select session_variable.get('colour', null::text);
+
+-- overrides must refer to a variable and hold a value of its type
+insert into session_variable.variable_overrides (variable_name, role_name, initial_value)
+values ('unknown', session_user, '1');
+insert into session_variable.variable_overrides (variable_name, role_name, initial_value)
+values ('limit', session_user, 'abc');
+insert into session_variable.variable_overrides (variable_name, application_name, initial_value)
+values ('colour', 'reporting', 'green');
+
+-- the overrides of a variable are dropped with it
+select session_variable.drop('colour');
+select count(*) from session_variable.variable_overrides where variable_name = 'colour';
+
+-- cleanup
+drop schema if exists session_variable cascade;
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('threshold', 'integer'::regtype, 10);
+select session_variable.create_constant('label', 'text'::regtype, 'none'::text);
+create table parallel_data as select g as id, 'row ' || g as description from generate_series(1, 100000) g;
+analyze parallel_data;
+
+-- the functions that only read may be executed in parallel workers
+select proname, proparallel from pg_catalog.pg_proc
+where pronamespace = 'session_variable'::regnamespace
+and proname in ('get', 'get_stable', 'get_constant', 'get_int4', 'set')
+order by proname;
+
+set parallel_setup_cost = 0;
+set parallel_tuple_cost = 0;
+set min_parallel_table_scan_size = 0;
+set max_parallel_workers_per_gather = 2;
+set parallel_leader_participation = off;
+
+-- the workers see the values of the session, not the initial values
+select session_variable.set('threshold', 90000);
+select count(*) from parallel_data where id > session_variable.get('threshold', null::integer);
+select count(*) from parallel_data where id > session_variable.get_int4('threshold');
+select session_variable.set('threshold', 99990);
+select count(*) from parallel_data where id > session_variable.get('threshold', null::integer);
+select session_variable.alter_value('label', 'row 1'::text);
+select count(*) from parallel_data where description = session_variable.get('label', null::text);
+
+-- only a superuser can set or read the state, and the leader replaces it anyway
+create role session_variable_parallel_user;
+set role session_variable_parallel_user;
+set session_variable.parallel_state = '00';
+do $$
+begin
+    perform pg_catalog.current_setting('session_variable.parallel_state');
+    raise notice 'parallel_state can be read';
+exception when insufficient_privilege then
+    raise notice 'parallel_state cannot be read';
+end;
+$$;
+reset role;
+drop role session_variable_parallel_user;
+set session_variable.parallel_state = '00';
+select count(*) from parallel_data where id > session_variable.get('threshold', null::integer);
+
+-- cleanup
+drop table parallel_data;
+drop schema if exists session_variable cascade;
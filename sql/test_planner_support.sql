@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+
+-- init
+create extension session_variable;
+select session_variable.init();
+
+create table planner_support_test
+( tenant_id int not null
+, payload text
+);
+insert into planner_support_test
+select i % 1000, 'row ' || i from generate_series(1, 10000) i;
+create index on planner_support_test (tenant_id);
+analyze planner_support_test;
+
+create function plan_contains(query text, fragment text)
+   returns boolean language plpgsql as $$
+declare
+    plan_line text;
+begin
+    for plan_line in execute 'explain (costs off) ' || query loop
+        if position(fragment in plan_line) > 0 then
+            return true;
+        end if;
+    end loop;
+    return false;
+end;
+$$;
+
+select session_variable.create_variable('tenant', 'integer'::regtype, 3);
+
+select plan_contains('select * from planner_support_test where tenant_id = session_variable.get_stable(''tenant'', 0)', 'InitPlan');
+select plan_contains('select * from planner_support_test where tenant_id = session_variable.get_stable(''tenant'', 0)', 'Index');
+select plan_contains('select * from planner_support_test where tenant_id = session_variable.get(''tenant'', 0)', 'InitPlan');         -- get() is volatile, so not replaced
+select plan_contains('select session_variable.get_stable(''tenant'', 0)', 'InitPlan');                                                 -- no from clause, so not replaced
+
+select count(*) from planner_support_test where tenant_id = session_variable.get_stable('tenant', 0);
+
+set plan_cache_mode = force_generic_plan;
+prepare by_tenant as
+select count(*) from planner_support_test where tenant_id = session_variable.get_stable('tenant', 0);
+execute by_tenant;
+select session_variable.set('tenant', 1001);
+execute by_tenant;
+select session_variable.set('tenant', null::int);
+execute by_tenant;
+deallocate by_tenant;
+reset plan_cache_mode;
+
+-- cleanup
+drop function plan_contains(text, text);
+drop table planner_support_test;
+drop schema if exists session_variable cascade;
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init, runs with session_variable.preload_database set to this database
+create extension session_variable;
+select session_variable.init();
+
+-- reloads until one takes the variables from the preloaded catalog
+create function wait_for_preload(previous bigint) returns bigint
+language plpgsql as $$
+declare
+    reloads bigint;
+begin
+    for i in 1..300 loop
+        perform session_variable.init();
+        select preloaded_reloads into reloads from session_variable.backend_stats();
+        if reloads > previous then
+            return reloads;
+        end if;
+        perform pg_sleep(0.1);
+    end loop;
+    return reloads;
+end;
+$$;
+
+-- the worker loads the catalog after a committed change
+select session_variable.create_variable('preloaded', 'text'::regtype, 'first'::text);
+select wait_for_preload(0) > 0 as preloaded;
+select session_variable.get('preloaded', null::text);
+
+-- and again after the next committed change
+select preloaded_reloads as reloads from session_variable.backend_stats() \gset
+select session_variable.alter_value('preloaded', 'second'::text);
+select wait_for_preload(:reloads) > :reloads as preloaded;
+select session_variable.get('preloaded', null::text);
+
+-- a transaction that changed the catalog reads the table itself
+select preloaded_reloads as reloads from session_variable.backend_stats() \gset
+begin;
+select session_variable.alter_value('preloaded', 'third'::text);
+select session_variable.init();
+select session_variable.get('preloaded', null::text);
+select preloaded_reloads = :reloads as fell_back from session_variable.backend_stats();
+rollback;
+
+-- after the rollback the preloaded catalog is up to date again
+select session_variable.init();
+select session_variable.get('preloaded', null::text);
+select preloaded_reloads > :reloads as preloaded from session_variable.backend_stats();
+
+-- cleanup
+drop function wait_for_preload(bigint);
+drop schema if exists session_variable cascade;
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+create type org_row as (org_id integer, org_name text);
+-- a result set variable keeps the rows of a query
+select session_variable.set_rows('permitted orgs', 'select g, ''org '' || g from generate_series(1, 3) g');
+select * from session_variable.rows('permitted orgs', null::org_row);
+select org_name from session_variable.rows('permitted orgs', null::org_row) where org_id = 2;
+-- the only column can be read as its type
+select session_variable.set_rows('org ids', 'select g from generate_series(10, 12) g');
+select * from session_variable.rows('org ids', null::integer);
+-- the planner estimates the number of rows
+do $$
+declare
+    plan json;
+begin
+    execute 'explain (format json) select * from session_variable.rows(''org ids'', null::integer)' into plan;
+    raise notice 'estimated rows: %', plan -> 0 -> 'Plan' ->> 'Plan Rows';
+end $$;
+-- a rollback does not undo set_rows()
+begin;
+select session_variable.set_rows('org ids', 'select 42');
+rollback;
+select * from session_variable.rows('org ids', null::integer);
+-- the rows must match row_type
+select * from session_variable.rows('permitted orgs', null::integer);
+select * from session_variable.rows('org ids', null::org_row);
+-- beyond work_mem the rows are written to a temporary file
+set work_mem = '64kB';
+select session_variable.set_rows('many orgs', 'select g, repeat(''x'', 100) from generate_series(1, 10000) g');
+select count(*), sum(org_id), max(length(org_name)) from session_variable.rows('many orgs', null::org_row);
+reset work_mem;
+-- a null query removes the result set variable
+select session_variable.set_rows('org ids', null);
+select * from session_variable.rows('org ids', null::integer);
+-- init() removes all result set variables
+select session_variable.init();
+select * from session_variable.rows('permitted orgs', null::org_row);
+select session_variable.set_rows(null, 'select 1');
+select session_variable.rows(null, null::integer);
+-- cleanup
+drop type org_row;
+drop schema if exists session_variable cascade;
@@ -158,6 +158,11 @@ drop function session_variable.variable_initialisation();
 select session_variable.init();
 select session_variable.get('numeric const', null::numeric);
 
+-- reloaded when used next, as in a background worker
+select session_variable.set('just text', 'changed in this session'::text);
+select session_variable.init_worker();
+select session_variable.get('just text', null::text);
+
 select session_variable.drop('just text');
 select session_variable.drop('varchar');
 select session_variable.drop('numeric const');
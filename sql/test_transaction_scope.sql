@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('request id', 'text'::regtype, 'none'::text, 'transaction');
+select session_variable.create_variable('counter', 'integer'::regtype, 0);
+
+-- a transaction scoped variable is reset when the transaction commits
+begin;
+select session_variable.set('request id', 'r1'::text);
+select session_variable.set('counter', 1);
+select session_variable.get('request id', null::text);
+commit;
+select session_variable.get('request id', null::text);
+select session_variable.get('counter', null::integer);
+
+-- and when it rolls back
+begin;
+select session_variable.set('request id', 'r2'::text);
+rollback;
+select session_variable.get('request id', null::text);
+
+-- a single statement is a transaction as well
+select session_variable.set('request id', 'r3'::text);
+select session_variable.get('request id', null::text);
+
+-- alter_value() changes the value it is reset to
+begin;
+select session_variable.set('request id', 'r4'::text);
+select session_variable.alter_value('request id', 'altered'::text);
+commit;
+select session_variable.get('request id', null::text);
+
+-- the scope is kept in the catalog
+select variable_name, variable_scope
+from session_variable.variables
+order by variable_name;
+select session_variable.init();
+begin;
+select session_variable.set('request id', 'r5'::text);
+commit;
+select session_variable.get('request id', null::text);
+
+-- a variable with a null initial value
+select session_variable.create_variable('acting user', 'text'::regtype, null::text, 'transaction');
+begin;
+select session_variable.set('acting user', 'someone'::text);
+commit;
+select session_variable.get('acting user', null::text) is null as is_reset;
+
+-- errors
+select session_variable.create_variable('wrong scope', 'text'::regtype, null::text, 'statement');
+
+-- cleanup
+drop schema if exists session_variable cascade;
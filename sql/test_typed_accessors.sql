@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('an int4', 'integer'::regtype, 12345);
+select session_variable.create_variable('an int8', 'bigint'::regtype, 1234567890123::bigint);
+select session_variable.create_variable('a bool', 'boolean'::regtype, true);
+select session_variable.create_variable('a text', 'text'::regtype, 'some text'::text);
+select session_variable.create_variable('a uuid', 'uuid'::regtype, 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid);
+select session_variable.create_variable('a timestamptz', 'timestamptz'::regtype, '2024-02-29 12:34:56+00'::timestamptz);
+select session_variable.create_constant('a numeric', 'numeric'::regtype, 42.0);
+
+select session_variable.get_int4('an int4');
+select session_variable.get_int8('an int8');
+select session_variable.get_bool('a bool');
+select session_variable.get_text('a text');
+select session_variable.get_uuid('a uuid');
+select session_variable.get_timestamptz('a timestamptz') = '2024-02-29 12:34:56+00'::timestamptz;
+
+select session_variable.get_int8('an int4');
+select session_variable.get_text('an int8');
+select session_variable.get_int4('a numeric');
+select session_variable.get_uuid('an int4');                                                -- fails: cannot be cast
+select session_variable.get_int4('does not exist');                                         -- fails: does not exist
+
+select session_variable.set_int4('an int4', 54321);
+select session_variable.set_int8('an int8', null);
+select session_variable.set_bool('a bool', false);
+select session_variable.set_text('a text', 'other text');
+select session_variable.set_uuid('a uuid', '00000000-0000-0000-0000-000000000000');
+select session_variable.set_timestamptz('a timestamptz', '2000-01-01 00:00:00+00');
+select session_variable.set_int4('a numeric', 1);                                           -- fails: constants cannot be set
+
+select session_variable.get_int4('an int4');
+select coalesce(session_variable.get_int8('an int8'), -1);
+select session_variable.get_bool('a bool');
+select session_variable.get_text('a text');
+select session_variable.get_uuid('a uuid');
+select session_variable.get_timestamptz('a timestamptz') = '2000-01-01 00:00:00+00'::timestamptz;
+
+select session_variable.set_int4('a text', 17);
+select session_variable.get('a text', null::text);
+
+select nr_variables from session_variable.backend_stats();
+select tree_depth from session_variable.backend_stats();
+select reload_calls = 1 and get_calls > 0 and set_calls > 0 and func_coercions > 0 and io_coercions > 0
+from session_variable.backend_stats();
+
+-- cleanup
+drop schema if exists session_variable cascade;
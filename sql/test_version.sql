@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Splendid Data Product Development B.V. 2013 - 2024
+ *
+ * This program is free software: You may redistribute and/or modify under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at Client's option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, Client should obtain one via www.gnu.org/licenses/.
+ */
+-- init
+create extension session_variable;
+select session_variable.init();
+
+select session_variable.create_variable('a number', 'integer'::regtype, 1);
+select session_variable.create_constant('a constant', 'text'::regtype, 'fixed'::text);
+select session_variable.version('a number') as number_version \gset
+select session_variable.version('a constant') as constant_version \gset
+
+-- reading does not change the version
+select session_variable.get('a number', null::integer);
+select session_variable.version('a number') = :number_version as unchanged;
+
+-- set() raises the version, also when the value stays the same
+select session_variable.set('a number', 2);
+select session_variable.version('a number') > :number_version as changed;
+select session_variable.version('a number') as number_version \gset
+select session_variable.set('a number', 2);
+select session_variable.version('a number') > :number_version as changed;
+
+-- alter_value() raises the version of a constant
+select session_variable.alter_value('a constant', 'other'::text);
+select session_variable.version('a constant') > :constant_version as changed;
+
+-- a reload raises the version
+select session_variable.version('a number') as number_version \gset
+select session_variable.init();
+select session_variable.version('a number') > :number_version as changed;
+
+-- errors
+select session_variable.version('does not exist');
+select session_variable.version(null);
+
+-- cleanup
+drop schema if exists session_variable cascade;